@@ -0,0 +1,969 @@
+﻿#include "Batch.h"
+#include "Bitboard.h"
+#include "Interleaved.h"
+#include "Parallel.h"
+#include "SolutionCache.h"
+#include "Symmetry.h"
+#include "Validate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Puzzles read from the stream before workers are started on them
+	size_t constexpr block_size = 1 << 14;
+
+	// Puzzles a worker takes from the shared cursor at a time
+	size_t constexpr chunk_size = 64;
+
+	// An output line is the solution and its newline
+	size_t constexpr record_size = batch::line_length + 1;
+
+	// Chunks of a mapped file per worker, enough that workers finish close
+	// together however the hard puzzles are spread through the file
+	size_t constexpr chunks_per_worker = 16;
+
+	// The solvers owned by one worker thread, one of each backend
+	struct Worker
+	{
+		Sudoku dancing_links;
+		InstrumentedSudoku instrumented;
+		InterleavedSudoku interleaved;
+		SpacedSudoku spaced;
+		BitboardSudoku bitboard;
+	};
+
+	/**
+		Hands each puzzle to parallel::solve, searching it with every thread
+	*/
+	struct SplitSolver
+	{
+		Sudoku const& prototype;
+		int32_t threads;
+
+		SolveResult loadGridAndSolve(Sudoku::Grid const& grid, Sudoku::Grid* solution)
+		{
+			return parallel::solve(prototype, grid, solution, SearchMode::FirstSolution, 0, threads);
+		}
+	};
+
+	/**
+		Looks each puzzle up in cache by its canonical form before handing it
+		to solver, on a miss solving the canonical puzzle and storing its
+		result. Solutions are mapped back through the inverse transform
+	*/
+	template <typename Solver>
+	struct CachedSolver
+	{
+		Solver& solver;
+		SolutionCache& cache;
+		uint64_t& hits;
+
+		SolveResult loadGridAndSolve(Sudoku::Grid const& grid, Sudoku::Grid* solution)
+		{
+			Sudoku::Grid canonical;
+			symmetry::Transform const transform = symmetry::canonicalize(grid, canonical);
+
+			SolveResult result;
+			SolutionCache::Entry entry;
+			if (cache.find(canonical, entry))
+			{
+				++hits;
+				result.solutions = entry.solved ? 1 : 0;
+			}
+			else
+			{
+				Sudoku::Grid canonical_solution;
+				result = solver.loadGridAndSolve(canonical, &canonical_solution);
+				entry.solved = result.solutions > 0;
+				if (entry.solved)
+				{
+					entry.solution = SolutionCache::pack(canonical_solution);
+				}
+
+				// a search the limits cut short may have found a solution later
+				if (!result.timeout)
+				{
+					cache.insert(canonical, entry);
+				}
+			}
+
+			if (entry.solved && solution)
+			{
+				*solution = symmetry::invert(transform, SolutionCache::unpack(entry.solution));
+			}
+			return result;
+		}
+	};
+
+	/**
+		Call work with solver, or solver behind options.cache when set
+	*/
+	template <typename Solver, typename Work>
+	void withCache(Solver& solver, batch::BatchOptions const& options, batch::BatchStats& stats,
+		Work&& work)
+	{
+		if (options.cache)
+		{
+			CachedSolver<Solver> cached{ solver, *options.cache, stats.cache_hits };
+			work(cached);
+		}
+		else
+		{
+			work(solver);
+		}
+	}
+
+	/**
+		Puzzles gathered so their clues are checked, and later their
+		solutions verified, validate::lanes at a time. Contradicting clues
+		are rejected without reaching the solver
+	*/
+	struct PuzzleGroup
+	{
+		Sudoku::Grid puzzles[validate::lanes];
+		// zeroed so the lanes of puzzles never solved are still defined
+		Sudoku::Grid solutions[validate::lanes]{};
+		char* records[validate::lanes];
+		bool consistent[validate::lanes];
+		bool solved[validate::lanes];
+		bool valid[validate::lanes];
+		size_t count = 0;
+	};
+
+	/**
+		Solve each of count puzzles in turn
+	*/
+	template <typename Solver>
+	void searchAll(Solver& sudoku, Sudoku::Grid const* const* puzzles, Sudoku::Grid* const* solutions,
+		SolveResult* results, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			results[i] = sudoku.loadGridAndSolve(*puzzles[i], solutions[i]);
+		}
+	}
+
+	void searchAll(InterleavedSudoku& sudoku, Sudoku::Grid const* const* puzzles,
+		Sudoku::Grid* const* solutions, SolveResult* results, size_t count)
+	{
+		sudoku.solveAll(puzzles, solutions, results, count);
+	}
+
+	/**
+		Verify the solutions of group, writing those that pass to their
+		records, and empty the group
+	*/
+	void writeGroup(PuzzleGroup& group, batch::BatchStats& stats)
+	{
+		// Unsolved lanes hold zeros or an earlier solution, their result unused
+		validate::checkSolutions(group.puzzles, group.solutions, group.count, group.valid);
+
+		for (size_t i = 0; i < group.count; ++i)
+		{
+			if (!group.solved[i])
+			{
+				continue;
+			}
+
+			if (group.valid[i])
+			{
+				++stats.solved;
+				batch::formatGrid(group.solutions[i], group.records[i]);
+			}
+			else
+			{
+				++stats.unverified;
+			}
+		}
+		group.count = 0;
+	}
+
+	/**
+		Solve the puzzles of group, writing the output line of each to its
+		record, and empty the group
+	*/
+	template <typename Solver>
+	void solveGroup(Solver& sudoku, PuzzleGroup& group, batch::BatchStats& stats)
+	{
+		validate::checkClues(group.puzzles, group.count, group.consistent);
+
+		// Only consistent puzzles are searched
+		size_t searched[validate::lanes];
+		Sudoku::Grid const* puzzles[validate::lanes];
+		Sudoku::Grid* solutions[validate::lanes];
+		SolveResult results[validate::lanes];
+		size_t count = 0;
+
+		for (size_t i = 0; i < group.count; ++i)
+		{
+			group.solved[i] = false;
+			if (!group.consistent[i])
+			{
+				++stats.unsolvable;
+				continue;
+			}
+
+			searched[count] = i;
+			puzzles[count] = &group.puzzles[i];
+			solutions[count] = &group.solutions[i];
+			++count;
+		}
+
+		searchAll(sudoku, puzzles, solutions, results, count);
+
+		for (size_t j = 0; j < count; ++j)
+		{
+			if (results[j].solutions > 0)
+			{
+				group.solved[searched[j]] = true;
+			}
+			else if (results[j].timeout)
+			{
+				++stats.timeouts;
+			}
+			else
+			{
+				++stats.unsolvable;
+			}
+		}
+
+		writeGroup(group, stats);
+	}
+
+	/**
+		Add the puzzle of line to group, its output line going to record,
+		solving the group once it is full. A malformed line is written
+		straight away
+	*/
+	template <typename Solver>
+	void solvePuzzle(Solver& sudoku, PuzzleGroup& group, char const* line, size_t length, char* record,
+		batch::BatchStats& stats)
+	{
+		std::memset(record, '.', batch::line_length);
+		record[batch::line_length] = '\n';
+
+		++stats.puzzles;
+		if (!batch::parsePuzzle(line, length, group.puzzles[group.count]))
+		{
+			++stats.malformed;
+			return;
+		}
+
+		group.records[group.count] = record;
+		if (++group.count == validate::lanes)
+		{
+			solveGroup(sudoku, group, stats);
+		}
+	}
+
+	/**
+		Solve puzzles [begin, end) of lines, each line_length characters,
+		writing the output line of each puzzle to the same index of records
+	*/
+	template <typename Solver>
+	void solveRange(Solver& sudoku, char const* lines, char* records,
+		size_t begin, size_t end, batch::BatchStats& stats)
+	{
+		PuzzleGroup group;
+		for (size_t i = begin; i < end; ++i)
+		{
+			solvePuzzle(sudoku, group, lines + i * batch::line_length, batch::line_length,
+				records + i * record_size, stats);
+		}
+		solveGroup(sudoku, group, stats);
+	}
+
+	/**
+		Call work with the dancing links solver of worker options ask for,
+		counting cache hits into stats
+	*/
+	template <typename Work>
+	void withDancingLinks(Worker& worker, batch::BatchOptions const& options, batch::BatchStats& stats,
+		Work&& work)
+	{
+		if (options.stats)
+		{
+			withCache(worker.instrumented, options, stats, work);
+		}
+		else if (options.engine == SearchEngine::Interleaved)
+		{
+			withCache(worker.interleaved, options, stats, work);
+		}
+		else
+		{
+			withCache(worker.dancing_links, options, stats, work);
+		}
+	}
+
+	/**
+		Call work with the solver of worker for the backend of options,
+		counting cache hits into stats
+	*/
+	template <typename Work>
+	void withSolver(Worker& worker, batch::BatchOptions const& options, batch::BatchStats& stats,
+		Work&& work)
+	{
+		if (options.backend == batch::Backend::Bitboard)
+		{
+			withCache(worker.bitboard, options, stats, work);
+		}
+		else if (options.backend == batch::Backend::SpacedLinks)
+		{
+			withCache(worker.spaced, options, stats, work);
+		}
+		else
+		{
+			withDancingLinks(worker, options, stats, work);
+		}
+	}
+
+	/**
+		Run work(worker) for every worker below count, on a thread each apart
+		from the first which runs on the calling thread
+	*/
+	template <typename Work>
+	void runWorkers(size_t count, Work const& work)
+	{
+		std::vector<std::thread> workers;
+		for (size_t worker = 1; worker < count; ++worker)
+		{
+			workers.emplace_back(work, worker);
+		}
+		work(0);
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void addCounts(batch::BatchStats& total, batch::BatchStats const& part)
+	{
+		total.puzzles += part.puzzles;
+		total.solved += part.solved;
+		total.unsolvable += part.unsolvable;
+		total.malformed += part.malformed;
+		total.timeouts += part.timeouts;
+		total.cache_hits += part.cache_hits;
+		total.unverified += part.unverified;
+		total.singles += part.singles;
+		total.routed_bitboard += part.routed_bitboard;
+		total.routed_dancing_links += part.routed_dancing_links;
+	}
+
+	/**
+		One solver of each kind per worker, kept for the whole run
+	*/
+	std::vector<Worker> makeWorkers(batch::BatchOptions const& options)
+	{
+		std::vector<Worker> solvers(static_cast<size_t>(std::max(options.threads, 1)));
+		for (Worker& worker : solvers)
+		{
+			worker.dancing_links.setEngine(options.engine);
+			worker.dancing_links.setPropagation(options.propagation);
+			worker.dancing_links.setLimits(options.limits);
+			worker.instrumented.setEngine(options.engine);
+			worker.instrumented.setPropagation(options.propagation);
+			worker.instrumented.setLimits(options.limits);
+			worker.interleaved.setPropagation(options.propagation);
+			worker.interleaved.setLimits(options.limits);
+			worker.spaced.setEngine(options.engine);
+			worker.spaced.setPropagation(options.propagation);
+			worker.spaced.setLimits(options.limits);
+			worker.bitboard.setLimits(options.limits);
+		}
+		return solvers;
+	}
+
+	/**
+		A puzzle Backend::Routed left to search, and where its output goes
+	*/
+	struct Pending
+	{
+		char const* line;
+		size_t length;
+		char* record;
+	};
+
+	/**
+		The puzzles one worker left to each search
+	*/
+	struct Queues
+	{
+		std::vector<Pending> dancing_links;
+		std::vector<Pending> bitboard;
+	};
+
+	/**
+		Route the puzzle of line, its output line going to record. Puzzles
+		singles solve are added to group, verified and written once it is
+		full, those left go to the queue of their search
+	*/
+	void routePuzzle(BitboardSudoku& bitboard, PuzzleGroup& group, Queues& queues, char const* line,
+		size_t length, char* record, batch::BatchStats& stats)
+	{
+		std::memset(record, '.', batch::line_length);
+		record[batch::line_length] = '\n';
+
+		Sudoku::Grid& puzzle = group.puzzles[group.count];
+		if (!batch::parsePuzzle(line, length, puzzle))
+		{
+			++stats.puzzles;
+			++stats.malformed;
+			return;
+		}
+
+		// Queued puzzles are counted once searched, by solvePuzzle
+		switch (batch::route(bitboard, puzzle, &group.solutions[group.count]))
+		{
+		case batch::Route::Solved:
+			++stats.puzzles;
+			++stats.singles;
+			group.records[group.count] = record;
+			group.solved[group.count] = true;
+			if (++group.count == validate::lanes)
+			{
+				writeGroup(group, stats);
+			}
+			break;
+		case batch::Route::Unsolvable:
+			++stats.puzzles;
+			++stats.unsolvable;
+			break;
+		case batch::Route::DancingLinks:
+			++stats.routed_dancing_links;
+			queues.dancing_links.push_back({ line, length, record });
+			break;
+		case batch::Route::Bitboard:
+			++stats.routed_bitboard;
+			queues.bitboard.push_back({ line, length, record });
+			break;
+		}
+	}
+
+	/**
+		Solve count pending puzzles with sudoku
+	*/
+	template <typename Solver>
+	void solvePending(Solver& sudoku, Pending const* pending, size_t count, batch::BatchStats& stats)
+	{
+		PuzzleGroup group;
+		for (size_t i = 0; i < count; ++i)
+		{
+			solvePuzzle(sudoku, group, pending[i].line, pending[i].length, pending[i].record, stats);
+		}
+		solveGroup(sudoku, group, stats);
+	}
+
+	/**
+		Solve puzzles with Backend::Routed, one thread per solver. On each
+		worker propagate(visit) calls visit(line, length, record) for every
+		puzzle the worker takes, which the worker routes. Once all are
+		routed the workers take chunks of the puzzles left, the dancing
+		links queue before the bitboard one so the puzzles likely slowest
+		are not left running alone at the end
+	*/
+	template <typename Propagate>
+	void solveRouted(std::vector<Worker>& solvers, batch::BatchOptions const& options,
+		Propagate const& propagate, batch::BatchStats& stats)
+	{
+		std::vector<Queues> queues(solvers.size());
+		std::vector<batch::BatchStats> worker_stats(solvers.size());
+
+		runWorkers(solvers.size(), [&](size_t worker)
+		{
+			batch::BatchStats local;
+			PuzzleGroup group;
+			propagate([&](char const* line, size_t length, char* record)
+			{
+				routePuzzle(solvers[worker].bitboard, group, queues[worker], line, length, record, local);
+			});
+			writeGroup(group, local);
+			worker_stats[worker] = local;
+		});
+
+		std::vector<Pending> pending;
+		for (Queues const& queue : queues)
+		{
+			pending.insert(pending.end(), queue.dancing_links.begin(), queue.dancing_links.end());
+		}
+		size_t const dancing_links = pending.size();
+		for (Queues const& queue : queues)
+		{
+			pending.insert(pending.end(), queue.bitboard.begin(), queue.bitboard.end());
+		}
+
+		std::atomic<size_t> cursor(0);
+		runWorkers(solvers.size(), [&](size_t worker)
+		{
+			batch::BatchStats& local = worker_stats[worker];
+			for (;;)
+			{
+				size_t const begin = cursor.fetch_add(chunk_size);
+				if (begin >= pending.size())
+				{
+					break;
+				}
+				size_t const end = std::min(begin + chunk_size, pending.size());
+
+				// a chunk may straddle the two queues
+				size_t const split = std::max(begin, std::min(end, dancing_links));
+				withDancingLinks(solvers[worker], options, local, [&](auto& sudoku)
+				{
+					solvePending(sudoku, pending.data() + begin, split - begin, local);
+				});
+				withCache(solvers[worker].bitboard, options, local, [&](auto& sudoku)
+				{
+					solvePending(sudoku, pending.data() + split, end - split, local);
+				});
+			}
+		});
+
+		for (batch::BatchStats const& local : worker_stats)
+		{
+			addCounts(stats, local);
+		}
+	}
+
+	/**
+		Solve count puzzles with one thread per solver, the calling thread
+		working with the first. Chunks are handed out through an atomic
+		cursor and results land at their input index, so output order is kept
+	*/
+	void solveBlock(std::vector<Worker>& solvers, batch::BatchOptions const& options,
+		char const* lines, char* records, size_t count, batch::BatchStats& stats)
+	{
+		std::atomic<size_t> cursor(0);
+
+		if (options.backend == batch::Backend::Routed)
+		{
+			solveRouted(solvers, options, [&](auto&& visit)
+			{
+				for (size_t begin = cursor.fetch_add(chunk_size); begin < count; begin = cursor.fetch_add(chunk_size))
+				{
+					for (size_t i = begin; i < std::min(begin + chunk_size, count); ++i)
+					{
+						visit(lines + i * batch::line_length, batch::line_length, records + i * record_size);
+					}
+				}
+			}, stats);
+			return;
+		}
+
+		std::vector<batch::BatchStats> worker_stats(solvers.size());
+		runWorkers(solvers.size(), [&](size_t worker)
+		{
+			// Counted locally so workers don't share cache lines per puzzle
+			batch::BatchStats local;
+			for (;;)
+			{
+				size_t const begin = cursor.fetch_add(chunk_size);
+				if (begin >= count)
+				{
+					break;
+				}
+				size_t const end = std::min(begin + chunk_size, count);
+				withSolver(solvers[worker], options, local, [&](auto& sudoku)
+				{
+					solveRange(sudoku, lines, records, begin, end, local);
+				});
+			}
+			worker_stats[worker] = local;
+		});
+
+		for (batch::BatchStats const& local : worker_stats)
+		{
+			addCounts(stats, local);
+		}
+	}
+
+	/**
+		Lines skipped rather than counted as puzzles, as solveStream does
+	*/
+	bool skipLine(char const* line, size_t length)
+	{
+		return length == 0 || line[0] == '#' || line[0] == '\r';
+	}
+
+	/**
+		A run of whole lines of a mapped file, and the index of the output
+		record of its first puzzle
+	*/
+	struct Chunk
+	{
+		char const* begin;
+		char const* end;
+		size_t first_record;
+	};
+
+	/**
+		Call visit(line, length) for each line of chunk that is not skipped
+	*/
+	template <typename Visit>
+	void forEachPuzzle(Chunk const& chunk, Visit&& visit)
+	{
+		char const* line = chunk.begin;
+		while (line < chunk.end)
+		{
+			char const* newline = static_cast<char const*>(std::memchr(line, '\n', chunk.end - line));
+			char const* const line_end = newline ? newline : chunk.end;
+			size_t const length = static_cast<size_t>(line_end - line);
+
+			if (!skipLine(line, length))
+			{
+				visit(line, length);
+			}
+			line = line_end + 1;
+		}
+	}
+
+	/**
+		Split size bytes of data into about pieces chunks, each ending just
+		past a newline or at the end of data
+	*/
+	std::vector<Chunk> splitLines(char const* data, size_t size, size_t pieces)
+	{
+		std::vector<Chunk> chunks;
+		size_t const step = std::max<size_t>(size / std::max<size_t>(pieces, 1), 1);
+
+		char const* begin = data;
+		char const* const end = data + size;
+		while (begin < end)
+		{
+			char const* split = begin + std::min(step, static_cast<size_t>(end - begin));
+			if (split < end)
+			{
+				char const* const newline = static_cast<char const*>(std::memchr(split, '\n', end - split));
+				split = newline ? newline + 1 : end;
+			}
+			chunks.push_back({ begin, split, 0 });
+			begin = split;
+		}
+		return chunks;
+	}
+
+#if !defined(_WIN32)
+	/**
+		A whole file mapped into memory, unmapped and closed on destruction
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		~MappedFile()
+		{
+			if (bytes)
+			{
+				munmap(bytes, length);
+			}
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+		}
+
+		/**
+			Map path for reading, an empty file maps to no bytes. Fails on
+			anything but a regular file, as a pipe or device has no size to
+			map however much it would give
+		*/
+		bool openRead(char const* path)
+		{
+			fd = open(path, O_RDONLY);
+			struct stat info;
+			if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+			{
+				return false;
+			}
+			length = static_cast<size_t>(info.st_size);
+			return map(PROT_READ, MAP_PRIVATE);
+		}
+
+		/**
+			Create or truncate path to size bytes and map it for writing
+		*/
+		bool create(char const* path, size_t size)
+		{
+			fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0)
+			{
+				return false;
+			}
+			length = size;
+			return map(PROT_READ | PROT_WRITE, MAP_SHARED);
+		}
+
+		char* data() const
+		{
+			return static_cast<char*>(bytes);
+		}
+
+		size_t size() const
+		{
+			return length;
+		}
+
+	private:
+		int fd = -1;
+		void* bytes = nullptr;
+		size_t length = 0;
+
+		bool map(int protection, int flags)
+		{
+			if (length == 0)
+			{
+				return true;
+			}
+
+			void* const mapped = mmap(nullptr, length, protection, flags, fd, 0);
+			if (mapped == MAP_FAILED)
+			{
+				return false;
+			}
+			bytes = mapped;
+			return true;
+		}
+	};
+#endif
+}
+
+namespace batch
+{
+	bool parsePuzzle(char const* line, size_t length, Sudoku::Grid& grid)
+	{
+		if (length < static_cast<size_t>(line_length))
+		{
+			return false;
+		}
+
+		for (int32_t i = 0; i < line_length; ++i)
+		{
+			char const c = line[i];
+
+			if (c == '.' || c == '0')
+			{
+				grid[i] = 0;
+			}
+			else if (c >= '1' && c <= '9')
+			{
+				grid[i] = c - '0';
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void formatGrid(Sudoku::Grid const& grid, char* out)
+	{
+		for (int32_t i = 0; i < line_length; ++i)
+		{
+			out[i] = static_cast<char>('0' + grid[i]);
+		}
+	}
+
+	Route route(BitboardSudoku& bitboard, Sudoku::Grid const& grid, Sudoku::Grid* solution)
+	{
+		BitboardSudoku::Propagation const left = bitboard.propagateGrid(grid, solution);
+		if (left.unsolvable)
+		{
+			return Route::Unsolvable;
+		}
+		if (left.empty == 0)
+		{
+			return Route::Solved;
+		}
+		return left.min_places < left.min_candidates ? Route::DancingLinks : Route::Bitboard;
+	}
+
+	BatchStats solveStream(std::istream& in, std::ostream& out, BatchOptions const& options)
+	{
+		auto const start = std::chrono::steady_clock::now();
+
+		std::vector<Worker> solvers = makeWorkers(options);
+
+		std::vector<char> lines(block_size * line_length);
+		std::vector<char> records(block_size * record_size);
+
+		BatchStats stats;
+		std::string line;
+		bool more = true;
+
+		while (more)
+		{
+			size_t count = 0;
+
+			while (count < block_size && (more = static_cast<bool>(std::getline(in, line))))
+			{
+				if (line.empty() || line[0] == '#' || line[0] == '\r')
+				{
+					continue;
+				}
+
+				// A short line is padded with '\0' so it fails to parse
+				char* const dest = &lines[count * line_length];
+				size_t const length = std::min(line.size(), static_cast<size_t>(line_length));
+				std::memcpy(dest, line.data(), length);
+				std::memset(dest + length, '\0', line_length - length);
+				++count;
+			}
+
+			if (count > 0 && options.split && options.backend == Backend::DancingLinks)
+			{
+				SplitSolver split{ solvers[0].dancing_links, static_cast<int32_t>(solvers.size()) };
+				withCache(split, options, stats, [&](auto& solver)
+				{
+					solveRange(solver, lines.data(), records.data(), 0, count, stats);
+				});
+				out.write(records.data(), static_cast<std::streamsize>(count * record_size));
+			}
+			else if (count > 0)
+			{
+				solveBlock(solvers, options, lines.data(), records.data(), count, stats);
+				out.write(records.data(), static_cast<std::streamsize>(count * record_size));
+			}
+		}
+
+		out.flush();
+
+		for (Worker const& worker : solvers)
+		{
+			stats.search.merge(worker.instrumented.stats());
+		}
+
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	bool solveMappedFile(char const* input, char const* output, BatchOptions const& options,
+		BatchStats& stats)
+	{
+#if defined(_WIN32)
+		(void)input;
+		(void)output;
+		(void)options;
+		(void)stats;
+		return false;
+#else
+		// splitting solves one puzzle at a time, which the stream does as well
+		if (options.split && options.backend == Backend::DancingLinks)
+		{
+			return false;
+		}
+
+		auto const start = std::chrono::steady_clock::now();
+
+		MappedFile in;
+		if (!in.openRead(input))
+		{
+			return false;
+		}
+		if (in.size() > 0)
+		{
+			madvise(in.data(), in.size(), MADV_SEQUENTIAL);
+		}
+
+		std::vector<Worker> solvers = makeWorkers(options);
+		std::vector<Chunk> chunks = splitLines(in.data(), in.size(), solvers.size() * chunks_per_worker);
+
+		// Count the puzzles of each chunk first, so every chunk knows where
+		// its records start and the output can be sized up front
+		std::vector<size_t> counts(chunks.size(), 0);
+		std::atomic<size_t> cursor(0);
+		runWorkers(solvers.size(), [&](size_t)
+		{
+			for (size_t i = cursor.fetch_add(1); i < chunks.size(); i = cursor.fetch_add(1))
+			{
+				forEachPuzzle(chunks[i], [&](char const*, size_t) { ++counts[i]; });
+			}
+		});
+
+		size_t records = 0;
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			chunks[i].first_record = records;
+			records += counts[i];
+		}
+
+		MappedFile out;
+		if (!out.create(output, records * record_size))
+		{
+			return false;
+		}
+
+		BatchStats total;
+		cursor = 0;
+		if (options.backend == Backend::Routed)
+		{
+			solveRouted(solvers, options, [&](auto&& visit)
+			{
+				for (size_t i = cursor.fetch_add(1); i < chunks.size(); i = cursor.fetch_add(1))
+				{
+					char* record = out.data() + chunks[i].first_record * record_size;
+					forEachPuzzle(chunks[i], [&](char const* line, size_t length)
+					{
+						visit(line, length, record);
+						record += record_size;
+					});
+				}
+			}, total);
+		}
+		else
+		{
+			std::vector<BatchStats> worker_stats(solvers.size());
+			runWorkers(solvers.size(), [&](size_t worker)
+			{
+				BatchStats local;
+				for (size_t i = cursor.fetch_add(1); i < chunks.size(); i = cursor.fetch_add(1))
+				{
+					char* record = out.data() + chunks[i].first_record * record_size;
+					withSolver(solvers[worker], options, local, [&](auto& sudoku)
+					{
+						PuzzleGroup group;
+						forEachPuzzle(chunks[i], [&](char const* line, size_t length)
+						{
+							solvePuzzle(sudoku, group, line, length, record, local);
+							record += record_size;
+						});
+						solveGroup(sudoku, group, local);
+					});
+				}
+				worker_stats[worker] = local;
+			});
+
+			for (BatchStats const& local : worker_stats)
+			{
+				addCounts(total, local);
+			}
+		}
+
+		for (Worker const& worker : solvers)
+		{
+			total.search.merge(worker.instrumented.stats());
+		}
+
+		total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stats = total;
+		return true;
+#endif
+	}
+}
@@ -0,0 +1,161 @@
+﻿#ifndef BATCH_H
+#define BATCH_H
+#include "Sudoku.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+class BitboardSudoku;
+class SolutionCache;
+
+// Solving files of puzzles in the common one puzzle per line format
+namespace batch
+{
+	// Characters in a puzzle line, one per cell in row major order
+	static int32_t constexpr line_length = Sudoku::grid_size;
+
+	/**
+		The solver puzzles are handed to
+	*/
+	enum class Backend
+	{
+		// Sudoku, the exact cover matrix with dancing links
+		DancingLinks,
+		// SpacedSudoku, the same matrix with its rows between spacer nodes
+		// as in Knuth's DLX2
+		SpacedLinks,
+		// BitboardSudoku, candidate masks with singles propagation
+		Bitboard,
+		// singles propagation alone first, the puzzles left unsolved sent
+		// to the bitboard or dancing links search, see route
+		Routed
+	};
+
+	/**
+		Where Backend::Routed sends a puzzle
+	*/
+	enum class Route
+	{
+		// singles solved it
+		Solved,
+		// contradicting clues, or singles ran into a contradiction
+		Unsolvable,
+		Bitboard,
+		DancingLinks
+	};
+
+	/**
+		How solveStream runs
+	*/
+	struct BatchOptions
+	{
+		int32_t threads = 1;
+		Backend backend = Backend::DancingLinks;
+		// used by Backend::DancingLinks and the puzzles Backend::Routed sends
+		// to dancing links, as is propagation, and by
+		// Backend::SpacedLinks where interleaved searches iteratively
+		SearchEngine engine = SearchEngine::Recursive;
+		bool propagation = false;
+		// solve one puzzle at a time with every thread searching part of
+		// it, for few puzzles that are each slow, only Backend::DancingLinks
+		bool split = false;
+		// bounds on the search of each puzzle, for every backend
+		SearchLimits limits;
+		// instrument the dancing links search into BatchStats::search, not
+		// used with split, nor with the interleaved engine, which is not
+		// instrumented
+		bool stats = false;
+		// when set, puzzles are brought to canonical form and looked up
+		// before searching, shared by every worker and kept by the caller
+		// so it can outlive the run
+		SolutionCache* cache = nullptr;
+	};
+
+	/**
+		Totals for a run of solveStream
+	*/
+	struct BatchStats
+	{
+		uint64_t puzzles = 0;
+		uint64_t solved = 0;
+		// parsed but have contradicting clues or no solution
+		uint64_t unsolvable = 0;
+		// lines that are not a puzzle in the 81 character format
+		uint64_t malformed = 0;
+		// ran out of their search limits before a solution was found
+		uint64_t timeouts = 0;
+		// answered from BatchOptions::cache without a search
+		uint64_t cache_hits = 0;
+		// solved, but the solution failed verification and was not
+		// written, which only a bug in a solver can cause
+		uint64_t unverified = 0;
+		// with Backend::Routed, puzzles solved by singles and those sent
+		// to each search
+		uint64_t singles = 0;
+		uint64_t routed_bitboard = 0;
+		uint64_t routed_dancing_links = 0;
+		double seconds = 0.0;
+		// totals of every search when BatchOptions::stats is set
+		SearchStats<3> search;
+	};
+
+	/**
+		Parse a puzzle from the first 81 characters of line, '.' or '0' mark
+		an empty cell and '1' to '9' a clue, anything past the 81st character
+		is ignored. Returns false when the line is shorter or holds any other
+		character
+	*/
+	bool parsePuzzle(char const* line, size_t length, Sudoku::Grid& grid);
+
+	/**
+		Write the 81 digits of grid to out, no terminator is added
+	*/
+	void formatGrid(Sudoku::Grid const& grid, char* out);
+
+	/**
+		Place the singles of grid with bitboard, writing solution when they
+		solve it, and otherwise pick the search for the rest from what is
+		left. When a digit missing from some unit has fewer cells left than
+		any empty cell has candidates the puzzle goes to dancing links,
+		which branches on such columns where bitboard only branches on
+		cells, every other puzzle to the bitboard search, the faster on
+		ordinary puzzles
+	*/
+	Route route(BitboardSudoku& bitboard, Sudoku::Grid const& grid, Sudoku::Grid* solution);
+
+	/**
+		Solve every puzzle line of in, writing one line per puzzle to out
+		holding the first solution found, or 81 '.' when the puzzle is
+		malformed, has no solution or hits the search limits. Empty lines
+		and lines starting with '#' are skipped. Clues are checked for
+		contradictions before any search and every solution is verified
+		before it is written, see validate.
+
+		Puzzles are read in blocks and spread over options.threads workers,
+		each owning its own solver, output keeps the order of the input.
+		Backend::Routed takes a block in two passes: singles first, then the
+		puzzles they leave from a queue per search, dancing links first as
+		those are likely the slowest
+	*/
+	BatchStats solveStream(std::istream& in, std::ostream& out, BatchOptions const& options = BatchOptions());
+
+	/**
+		Solve the puzzle file input as solveStream does, writing to the file
+		output. Both files are mapped into memory: workers parse puzzles
+		straight from the mapped input, split into chunks on line
+		boundaries, and write each solution to its fixed offset of the
+		mapped output, so nothing is copied or allocated per puzzle and
+		workers never wait on one another.
+
+		Returns false and leaves stats alone when a file can't be mapped,
+		input is not a regular file, where mapping isn't supported, or
+		with BatchOptions::split, so the caller can fall back to
+		solveStream. output must not be input, as it is truncated while
+		input is still mapped
+	*/
+	bool solveMappedFile(char const* input, char const* output, BatchOptions const& options,
+		BatchStats& stats);
+}
+#endif // BATCH_H
@@ -0,0 +1,476 @@
+﻿/**
+	Benchmark of every solver over a few standard kinds of puzzle
+
+	Each bundled corpus is built from a handful of well known seed puzzles,
+	expanded by transformations that keep the number of solutions, so every
+	run and every commit measures exactly the same puzzles. Puzzle files in
+	the one per line format can be added as further corpora.
+*/
+#include "Batch.h"
+#include "Bitboard.h"
+#include "Interleaved.h"
+#include "Sudoku.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Corpus
+	{
+		std::string name;
+		std::vector<Sudoku::Grid> puzzles;
+	};
+
+	/**
+		The seeds of a bundled corpus
+	*/
+	struct Seeds
+	{
+		char const* name;
+		// whether the corpus is expanded to the requested size, or is only
+		// the seeds as some solvers need seconds for each
+		bool expand;
+		std::vector<char const*> puzzles;
+	};
+
+	std::vector<Seeds> const bundled = {
+		// solved by singles alone, or nearly so
+		{ "easy", true, {
+			"003020600900305001001806400008102900700000008006708200002609500800203009005010300",
+			"200080300060070084030500209000105408000000000402706000301007040720040060004010003",
+			"000000907000420180000705026100904000050000040000507009920108000034059000507000000",
+			".7.48.13.............56..8..6...8.7..41..6.....8....1..9.3..2.8..5..2...4...7.5..",
+		} },
+		// Arto Inkala's puzzle and AI Escargot
+		{ "hard", true, {
+			"8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",
+			"1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+		} },
+		// the fewest clues a puzzle with a unique solution can have
+		{ "17-clue", true, {
+			"000000010400000000020000000000050407008000300001090000300400200050100000000806000",
+			"4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+			"52...6.........7.13...........4..8..6......5...........418.........3..2...87.....",
+			"000000012000035000000600070700000300000400800100000000000120000080000040050000600",
+			"..............3.85..1.2.......5.7.....4...1...9.......5......73..2.1........4...9",
+		} },
+		// no solution, many solutions and no clues at all
+		{ "pathological", false, {
+			".....5.8....6.1.43..........1.5........1.6...3.......553.....61........4.........",
+			".....6....59.....82....8....45........3........6..3.54...325..6..................",
+			".................................................................................",
+		} },
+	};
+
+	/**
+		A solver as the benchmark runs it
+	*/
+	struct Engine
+	{
+		char const* name;
+		batch::Backend backend;
+		SearchEngine engine;
+		bool propagation;
+	};
+
+	Engine const engines[] = {
+		{ "dlx", batch::Backend::DancingLinks, SearchEngine::Recursive, false },
+		{ "dlx-iterative", batch::Backend::DancingLinks, SearchEngine::Iterative, false },
+		{ "dlx-interleaved", batch::Backend::DancingLinks, SearchEngine::Interleaved, false },
+		{ "dlx-propagate", batch::Backend::DancingLinks, SearchEngine::Recursive, true },
+		{ "dlx2", batch::Backend::SpacedLinks, SearchEngine::Recursive, false },
+		{ "dlx2-propagate", batch::Backend::SpacedLinks, SearchEngine::Recursive, true },
+		{ "bitboard", batch::Backend::Bitboard, SearchEngine::Recursive, false },
+		{ "routed", batch::Backend::Routed, SearchEngine::Recursive, false },
+		{ "routed-propagate", batch::Backend::Routed, SearchEngine::Recursive, true },
+	};
+
+	/**
+		Backend::Routed one puzzle at a time, singles and then the search
+		batch::route picks
+	*/
+	struct RoutedSolver
+	{
+		BitboardSudoku& bitboard;
+		Sudoku& dancing_links;
+
+		SolveResult loadGridAndSolve(Sudoku::Grid const& grid, Sudoku::Grid* solution)
+		{
+			SolveResult result;
+			switch (batch::route(bitboard, grid, solution))
+			{
+			case batch::Route::Solved:
+				result.solutions = 1;
+				return result;
+			case batch::Route::Unsolvable:
+				return result;
+			case batch::Route::DancingLinks:
+				return dancing_links.loadGridAndSolve(grid, solution);
+			default:
+				return bitboard.loadGridAndSolve(grid, solution);
+			}
+		}
+	};
+
+	struct Measurement
+	{
+		uint64_t puzzles = 0;
+		uint64_t solved = 0;
+		double seconds = 0.0;
+		double p50 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	/**
+		A puzzle with as many solutions as grid, its rows permuted within
+		each band and the bands permuted, likewise for columns and stacks,
+		its digits relabelled and possibly transposed
+	*/
+	Sudoku::Grid transform(Sudoku::Grid const& grid, std::mt19937& rng)
+	{
+		auto const line = [&rng]()
+		{
+			std::array<int32_t, 3> bands = { 0, 1, 2 };
+			std::shuffle(bands.begin(), bands.end(), rng);
+
+			std::array<int32_t, 9> order;
+			for (int32_t b = 0; b < 3; ++b)
+			{
+				std::array<int32_t, 3> inner = { 0, 1, 2 };
+				std::shuffle(inner.begin(), inner.end(), rng);
+				for (int32_t i = 0; i < 3; ++i)
+				{
+					order[b * 3 + i] = bands[b] * 3 + inner[i];
+				}
+			}
+			return order;
+		};
+
+		std::array<int32_t, 9> const rows = line();
+		std::array<int32_t, 9> const cols = line();
+
+		std::array<int32_t, 10> digits = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		std::shuffle(digits.begin() + 1, digits.end(), rng);
+
+		bool const transpose = (rng() & 1) != 0;
+
+		Sudoku::Grid out;
+		for (int32_t r = 0; r < 9; ++r)
+		{
+			for (int32_t c = 0; c < 9; ++c)
+			{
+				int32_t const from = transpose ? cols[c] * 9 + rows[r] : rows[r] * 9 + cols[c];
+				out[r * 9 + c] = digits[grid[from]];
+			}
+		}
+		return out;
+	}
+
+	Corpus expand(Seeds const& seeds, size_t count)
+	{
+		// Seeded the same every run, so runs can be compared
+		std::mt19937 rng(20220219);
+
+		Corpus corpus;
+		corpus.name = seeds.name;
+		for (size_t i = 0; i < count; ++i)
+		{
+			char const* const seed = seeds.puzzles[i % seeds.puzzles.size()];
+			Sudoku::Grid grid;
+			batch::parsePuzzle(seed, std::strlen(seed), grid);
+
+			// the seeds themselves come first, untransformed
+			corpus.puzzles.push_back(i < seeds.puzzles.size() ? grid : transform(grid, rng));
+		}
+		return corpus;
+	}
+
+	bool loadCorpus(char const* path, Corpus& corpus)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+
+		corpus.name = path;
+		std::string line;
+		Sudoku::Grid grid;
+		while (std::getline(file, line))
+		{
+			if (batch::parsePuzzle(line.data(), line.size(), grid))
+			{
+				corpus.puzzles.push_back(grid);
+			}
+		}
+		return true;
+	}
+
+	double percentile(std::vector<double> const& sorted, double p)
+	{
+		size_t const index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+		return sorted[index];
+	}
+
+	/**
+		Fill in the puzzles and latency percentiles of result
+	*/
+	void summarize(std::vector<double>& latencies, Measurement& result)
+	{
+		result.puzzles = latencies.size();
+		if (!latencies.empty())
+		{
+			std::sort(latencies.begin(), latencies.end());
+			result.p50 = percentile(latencies, 0.50);
+			result.p99 = percentile(latencies, 0.99);
+			result.max = latencies.back();
+		}
+	}
+
+	/**
+		Solve every puzzle of corpus one at a time on a single thread,
+		timing each
+	*/
+	template <typename Solver>
+	Measurement measure(Solver& solver, Corpus const& corpus)
+	{
+		Measurement result;
+		std::vector<double> latencies;
+		latencies.reserve(corpus.puzzles.size());
+
+		Sudoku::Grid solution;
+		for (Sudoku::Grid const& puzzle : corpus.puzzles)
+		{
+			Clock::time_point const start = Clock::now();
+			SolveResult const solved = solver.loadGridAndSolve(puzzle, &solution);
+			double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+			latencies.push_back(seconds);
+			result.seconds += seconds;
+			result.solved += solved.solutions > 0 ? 1 : 0;
+		}
+
+		summarize(latencies, result);
+		return result;
+	}
+
+	/**
+		Solve the puzzles of corpus InterleavedSudoku::ways at a time on a
+		single thread. The searches of a group finish together, so each
+		puzzle is given the time of its group as its latency
+	*/
+	Measurement measureInterleaved(InterleavedSudoku& solver, Corpus const& corpus)
+	{
+		Measurement result;
+		std::vector<double> latencies;
+		latencies.reserve(corpus.puzzles.size());
+
+		size_t constexpr ways = InterleavedSudoku::ways;
+		Sudoku::Grid solution_grids[ways];
+		Sudoku::Grid const* puzzles[ways];
+		Sudoku::Grid* solutions[ways];
+		SolveResult results[ways];
+
+		for (size_t begin = 0; begin < corpus.puzzles.size(); begin += ways)
+		{
+			size_t const count = std::min(ways, corpus.puzzles.size() - begin);
+			for (size_t i = 0; i < count; ++i)
+			{
+				puzzles[i] = &corpus.puzzles[begin + i];
+				solutions[i] = &solution_grids[i];
+			}
+
+			Clock::time_point const start = Clock::now();
+			solver.solveAll(puzzles, solutions, results, count);
+			double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+			result.seconds += seconds;
+			for (size_t i = 0; i < count; ++i)
+			{
+				latencies.push_back(seconds);
+				result.solved += results[i].solutions > 0 ? 1 : 0;
+			}
+		}
+
+		summarize(latencies, result);
+		return result;
+	}
+
+	/**
+		value as a quoted JSON string
+	*/
+	std::string jsonString(std::string const& value)
+	{
+		std::string out = "\"";
+		for (char const c : value)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out += '\\';
+				out += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				// control characters may only appear escaped
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+				out += escaped;
+			}
+			else
+			{
+				out += c;
+			}
+		}
+		return out + "\"";
+	}
+
+	void printUsage(char const* name)
+	{
+		std::cerr << "usage: " << name << " [--puzzles N] [--json] [--label L] [file...]\n"
+			<< "  file         also benchmark the puzzles of file, one per line\n"
+			<< "  --puzzles N  puzzles in each bundled corpus but pathological, 1000 by default\n"
+			<< "  --json       print one JSON object per corpus and engine\n"
+			<< "  --label L    name the run in JSON output, such as a commit\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = 1000;
+	bool json = false;
+	std::string label;
+	std::vector<Corpus> corpora;
+	std::vector<char const*> paths;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (std::strcmp(argv[i], "--puzzles") == 0 && i + 1 < argc)
+		{
+			count = static_cast<size_t>(std::max(std::atoi(argv[++i]), 1));
+		}
+		else if (std::strcmp(argv[i], "--json") == 0)
+		{
+			json = true;
+		}
+		else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+		{
+			label = argv[++i];
+		}
+		else if (argv[i][0] != '-')
+		{
+			paths.push_back(argv[i]);
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	for (Seeds const& seeds : bundled)
+	{
+		corpora.push_back(expand(seeds, seeds.expand ? count : seeds.puzzles.size()));
+	}
+
+	for (char const* path : paths)
+	{
+		Corpus corpus;
+		if (!loadCorpus(path, corpus))
+		{
+			std::cerr << "could not open " << path << "\n";
+			return 1;
+		}
+		corpora.push_back(corpus);
+	}
+
+	if (!json)
+	{
+		std::cout << std::left << std::setw(16) << "corpus" << std::setw(16) << "engine"
+			<< std::right << std::setw(9) << "puzzles" << std::setw(9) << "solved"
+			<< std::setw(12) << "puzzles/s" << std::setw(10) << "p50 us"
+			<< std::setw(10) << "p99 us" << std::setw(10) << "max us" << "\n";
+	}
+
+	Sudoku dancing_links;
+	SpacedSudoku spaced;
+	BitboardSudoku bitboard;
+	InterleavedSudoku interleaved;
+
+	for (Corpus const& corpus : corpora)
+	{
+		for (Engine const& engine : engines)
+		{
+			Measurement result;
+			if (engine.backend == batch::Backend::Bitboard)
+			{
+				result = measure(bitboard, corpus);
+			}
+			else if (engine.backend == batch::Backend::SpacedLinks)
+			{
+				spaced.setEngine(engine.engine);
+				spaced.setPropagation(engine.propagation);
+				result = measure(spaced, corpus);
+			}
+			else if (engine.engine == SearchEngine::Interleaved)
+			{
+				interleaved.setPropagation(engine.propagation);
+				result = measureInterleaved(interleaved, corpus);
+			}
+			else if (engine.backend == batch::Backend::Routed)
+			{
+				dancing_links.setEngine(engine.engine);
+				dancing_links.setPropagation(engine.propagation);
+				RoutedSolver routed{ bitboard, dancing_links };
+				result = measure(routed, corpus);
+			}
+			else
+			{
+				dancing_links.setEngine(engine.engine);
+				dancing_links.setPropagation(engine.propagation);
+				result = measure(dancing_links, corpus);
+			}
+
+			double const rate = result.seconds > 0.0 ? result.puzzles / result.seconds : 0.0;
+
+			if (json)
+			{
+				std::cout << "{\"label\":" << jsonString(label) << ",\"corpus\":" << jsonString(corpus.name)
+					<< ",\"engine\":" << jsonString(engine.name) << ",\"puzzles\":" << result.puzzles
+					<< ",\"solved\":" << result.solved << ",\"seconds\":" << result.seconds
+					<< ",\"puzzles_per_second\":" << rate << ",\"p50_us\":" << result.p50 * 1e6
+					<< ",\"p99_us\":" << result.p99 * 1e6 << ",\"max_us\":" << result.max * 1e6 << "}\n";
+			}
+			else
+			{
+				std::cout << std::left << std::setw(16) << corpus.name << std::setw(16) << engine.name
+					<< std::right << std::setw(9) << result.puzzles << std::setw(9) << result.solved
+					<< std::fixed << std::setprecision(0) << std::setw(12) << rate
+					<< std::setprecision(1) << std::setw(10) << result.p50 * 1e6
+					<< std::setw(10) << result.p99 * 1e6 << std::setw(10) << result.max * 1e6
+					<< std::defaultfloat << "\n";
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,365 @@
+﻿#include "Bitboard.h"
+#include "Bits.h"
+
+#include <algorithm>
+
+namespace
+{
+	// The cells of each unit, rows first then columns then boxes
+	struct Units
+	{
+		uint8_t cells[27][9];
+	};
+
+	constexpr Units buildUnits()
+	{
+		Units units{};
+		for (int32_t i = 0; i < 9; ++i)
+		{
+			for (int32_t j = 0; j < 9; ++j)
+			{
+				units.cells[i][j] = static_cast<uint8_t>(i * 9 + j);
+				units.cells[9 + i][j] = static_cast<uint8_t>(j * 9 + i);
+				units.cells[18 + i][j] = static_cast<uint8_t>((i / 3) * 27 + (i % 3) * 3 + (j / 3) * 9 + j % 3);
+			}
+		}
+		return units;
+	}
+
+	constexpr Units units = buildUnits();
+
+	constexpr int32_t boxOf(int32_t cell)
+	{
+		return (cell / 27) * 3 + (cell % 9) / 3;
+	}
+}
+
+void BitboardSudoku::setLimits(SearchLimits const& limits)
+{
+	search_limits = limits;
+}
+
+SearchLimits const& BitboardSudoku::limits() const
+{
+	return search_limits;
+}
+
+SolveResult BitboardSudoku::loadGridAndSolve(Grid const& grid, Grid* solution,
+	SearchMode mode, uint64_t limit)
+{
+	first_solution = solution;
+	on_solution = nullptr;
+	return solve(grid, mode, limit);
+}
+
+SolveResult BitboardSudoku::loadGridAndSolve(Grid const& grid, SolutionCallback const& callback,
+	SearchMode mode, uint64_t limit)
+{
+	first_solution = nullptr;
+	on_solution = callback ? &callback : nullptr;
+	return solve(grid, mode, limit);
+}
+
+SolveResult BitboardSudoku::solve(Grid const& grid, SearchMode mode, uint64_t limit)
+{
+	solution_limit = solutionLimit(mode, limit);
+	solution_count = 0;
+	node_count = 0;
+	timed_out = false;
+
+	Board board;
+	SolveResult result;
+	result.invalid = !load(grid, board);
+
+	if (!result.invalid && solution_limit > 0)
+	{
+		if (search_limits.time != std::chrono::steady_clock::duration::zero())
+		{
+			deadline = std::chrono::steady_clock::now() + search_limits.time;
+		}
+		search(board);
+	}
+
+	result.solutions = solution_count;
+	result.timeout = timed_out;
+	result.nodes = node_count;
+	return result;
+}
+
+BitboardSudoku::Propagation BitboardSudoku::propagateGrid(Grid const& grid, Grid* solution)
+{
+	Propagation result;
+
+	Board board;
+	if (!load(grid, board) || !propagate(board))
+	{
+		result.unsolvable = true;
+		return result;
+	}
+
+	result.empty = board.empty;
+	if (board.empty == 0)
+	{
+		if (solution)
+		{
+			for (int32_t cell = 0; cell < grid_size; ++cell)
+			{
+				(*solution)[cell] = board.cells[cell];
+			}
+		}
+		return result;
+	}
+
+	result.min_candidates = 9;
+	result.min_places = 9;
+	for (int32_t unit = 0; unit < 27; ++unit)
+	{
+		int32_t places[9] = {};
+		uint32_t missing = 0;
+
+		for (int32_t j = 0; j < 9; ++j)
+		{
+			int32_t const cell = units.cells[unit][j];
+			if (board.cells[cell] != 0)
+			{
+				continue;
+			}
+
+			uint32_t const cand = candidates(board, cell);
+			missing |= cand;
+			for (uint32_t rest = cand; rest != 0; rest &= rest - 1)
+			{
+				++places[bits::countTrailingZeros(rest)];
+			}
+
+			// every empty cell is in a row, so rows alone see each once
+			if (unit < 9)
+			{
+				result.min_candidates = std::min(result.min_candidates, bits::popcount(cand));
+			}
+		}
+
+		for (; missing != 0; missing &= missing - 1)
+		{
+			result.min_places = std::min(result.min_places, places[bits::countTrailingZeros(missing)]);
+		}
+	}
+	return result;
+}
+
+bool BitboardSudoku::load(Grid const& grid, Board& board)
+{
+	board = {};
+	board.empty = grid_size;
+
+	bool valid = true;
+	for (int32_t cell = 0; cell < grid_size; ++cell)
+	{
+		int32_t const value = grid[cell];
+
+		if (value < 0 || value > 9)
+		{
+			valid = false;
+		}
+		else if (value != 0)
+		{
+			// a clue whose digit its row, column or box already holds
+			if ((candidates(board, cell) & (1u << (value - 1))) == 0)
+			{
+				valid = false;
+			}
+			else
+			{
+				place(board, cell, value);
+			}
+		}
+	}
+	return valid;
+}
+
+uint32_t BitboardSudoku::candidates(Board const& board, int32_t cell)
+{
+	return ~(board.rows[cell / 9] | board.cols[cell % 9] | board.boxes[boxOf(cell)]) & all_digits;
+}
+
+void BitboardSudoku::place(Board& board, int32_t cell, int32_t digit)
+{
+	uint16_t const bit = static_cast<uint16_t>(1u << (digit - 1));
+
+	board.cells[cell] = static_cast<uint8_t>(digit);
+	board.rows[cell / 9] |= bit;
+	board.cols[cell % 9] |= bit;
+	board.boxes[boxOf(cell)] |= bit;
+	--board.empty;
+}
+
+bool BitboardSudoku::propagate(Board& board)
+{
+	bool progress = true;
+
+	while (progress && board.empty > 0)
+	{
+		progress = false;
+
+		// naked singles, a cell with one candidate left
+		for (int32_t cell = 0; cell < grid_size; ++cell)
+		{
+			if (board.cells[cell] != 0)
+			{
+				continue;
+			}
+
+			uint32_t const cand = candidates(board, cell);
+			if (cand == 0)
+			{
+				return false;
+			}
+
+			if (bits::popcount(cand) == 1)
+			{
+				place(board, cell, bits::countTrailingZeros(cand) + 1);
+				progress = true;
+			}
+		}
+
+		// hidden singles, a digit with one cell left in a unit
+		for (int32_t unit = 0; unit < 27; ++unit)
+		{
+			uint32_t once = 0;
+			uint32_t twice = 0;
+			uint32_t placed = 0;
+
+			for (int32_t j = 0; j < 9; ++j)
+			{
+				int32_t const cell = units.cells[unit][j];
+				if (board.cells[cell] != 0)
+				{
+					placed |= 1u << (board.cells[cell] - 1);
+				}
+				else
+				{
+					uint32_t const cand = candidates(board, cell);
+					twice |= once & cand;
+					once |= cand;
+				}
+			}
+
+			if ((once | placed) != all_digits)
+			{
+				return false;
+			}
+
+			for (uint32_t hidden = once & ~twice; hidden != 0; hidden &= hidden - 1)
+			{
+				int32_t const digit = bits::countTrailingZeros(hidden);
+
+				// An earlier single of this unit may have taken the only
+				// cell left for the digit
+				bool found = false;
+				for (int32_t j = 0; j < 9 && !found; ++j)
+				{
+					int32_t const cell = units.cells[unit][j];
+					if (board.cells[cell] == 0 && (candidates(board, cell) >> digit & 1u) != 0)
+					{
+						place(board, cell, digit + 1);
+						found = true;
+					}
+				}
+
+				if (!found)
+				{
+					return false;
+				}
+				progress = true;
+			}
+		}
+	}
+
+	return true;
+}
+
+void BitboardSudoku::reportSolution(Board const& board)
+{
+	Grid grid;
+	for (int32_t cell = 0; cell < grid_size; ++cell)
+	{
+		grid[cell] = board.cells[cell];
+	}
+
+	if (first_solution && solution_count == 0)
+	{
+		*first_solution = grid;
+	}
+
+	if (on_solution)
+	{
+		(*on_solution)(grid);
+	}
+}
+
+bool BitboardSudoku::outOfLimits()
+{
+	if (search_limits.nodes != 0 && node_count == search_limits.nodes)
+	{
+		timed_out = true;
+	}
+	else if (search_limits.time != std::chrono::steady_clock::duration::zero() &&
+		node_count % poll_interval == 0 && std::chrono::steady_clock::now() >= deadline)
+	{
+		timed_out = true;
+	}
+	else
+	{
+		++node_count;
+	}
+	return timed_out;
+}
+
+bool BitboardSudoku::search(Board board)
+{
+	if (outOfLimits())
+	{
+		return true;
+	}
+
+	if (!propagate(board))
+	{
+		return false;
+	}
+
+	if (board.empty == 0)
+	{
+		reportSolution(board);
+		return ++solution_count >= solution_limit;
+	}
+
+	// Branch on the empty cell with the fewest candidates, after
+	// propagation none has fewer than two
+	int32_t best = -1;
+	int32_t best_count = 10;
+	for (int32_t cell = 0; cell < grid_size && best_count > 2; ++cell)
+	{
+		if (board.cells[cell] == 0)
+		{
+			int32_t const count = bits::popcount(candidates(board, cell));
+			if (count < best_count)
+			{
+				best = cell;
+				best_count = count;
+			}
+		}
+	}
+
+	for (uint32_t cand = candidates(board, best); cand != 0; cand &= cand - 1)
+	{
+		Board next = board;
+		place(next, best, bits::countTrailingZeros(cand) + 1);
+
+		if (search(next))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,131 @@
+﻿#ifndef BITBOARD_H
+#define BITBOARD_H
+#include "Sudoku.h"
+
+#include <chrono>
+#include <cstdint>
+
+/**
+	A 9x9 solver keeping a 9 bit mask of the digits used by each row, column
+	and box. Candidates of a cell are the digits none of its units use, naked
+	and hidden singles are placed until none are left before branching on
+	the cell with the fewest candidates.
+
+	It takes the same grids and gives the same results as Sudoku, though
+	when a puzzle has several solutions they may be found in another order
+*/
+class BitboardSudoku
+{
+public:
+	static int32_t constexpr grid_size = Sudoku::grid_size;
+
+	using Grid = Sudoku::Grid;
+	using SolutionCallback = Sudoku::SolutionCallback;
+
+	// The deadline is checked once in this many search nodes
+	static uint32_t constexpr poll_interval = 1024;
+
+	/**
+		Bound the nodes and time of each search, as for Sudoku. A search
+		running out stops with the solutions found so far and the result
+		marked timeout
+	*/
+	void setLimits(SearchLimits const& limits);
+	SearchLimits const& limits() const;
+
+	/**
+		Solve the grid, limit is only used by SearchMode::CountUpTo. The
+		first solution found is written to solution when it is not null
+	*/
+	SolveResult loadGridAndSolve(Grid const& grid, Grid* solution,
+		SearchMode mode = SearchMode::FirstSolution, uint64_t limit = 0);
+
+	/**
+		As above but on_solution is called with every solution found
+	*/
+	SolveResult loadGridAndSolve(Grid const& grid, SolutionCallback const& on_solution,
+		SearchMode mode = SearchMode::CountAll, uint64_t limit = 0);
+
+	/**
+		What placing singles from the clues leaves of a puzzle, a cheap
+		measure of how hard the search for the rest will be
+	*/
+	struct Propagation
+	{
+		// the clues contradict, or singles ran into a contradiction
+		bool unsolvable = false;
+		// cells still empty, none once singles solved the puzzle
+		int32_t empty = 0;
+		// the fewest candidates of an empty cell, and the fewest cells a
+		// digit missing from a unit has left, the two kinds of column of
+		// the exact cover matrix
+		int32_t min_candidates = 0;
+		int32_t min_places = 0;
+	};
+
+	/**
+		Place naked and hidden singles of grid without branching, writing
+		the solution when that fills the grid
+	*/
+	Propagation propagateGrid(Grid const& grid, Grid* solution);
+
+private:
+	// Bit d - 1 stands for the digit d
+	static uint32_t constexpr all_digits = 0x1FF;
+
+	/**
+		A partly filled grid, small enough that each branch of the search
+		works on its own copy rather than undoing moves
+	*/
+	struct Board
+	{
+		uint8_t cells[grid_size];
+		uint16_t rows[9];
+		uint16_t cols[9];
+		uint16_t boxes[9];
+		int32_t empty;
+	};
+
+	uint64_t solution_count = 0;
+	uint64_t solution_limit = 0;
+
+	SearchLimits search_limits;
+	uint64_t node_count = 0;
+	std::chrono::steady_clock::time_point deadline;
+	bool timed_out = false;
+
+	// Destinations for solutions found by the current search
+	Grid* first_solution = nullptr;
+	SolutionCallback const* on_solution = nullptr;
+
+	SolveResult solve(Grid const& grid, SearchMode mode, uint64_t limit);
+
+	/**
+		Place the clues of grid on an empty board, returns false when a
+		value is out of range or repeats a digit of its row, column or box
+	*/
+	static bool load(Grid const& grid, Board& board);
+
+	static uint32_t candidates(Board const& board, int32_t cell);
+	static void place(Board& board, int32_t cell, int32_t digit);
+
+	/**
+		Place naked and hidden singles until there are none left, returns
+		false if a cell or a digit of some unit is left without a place
+	*/
+	static bool propagate(Board& board);
+
+	void reportSolution(Board const& board);
+
+	/**
+		Count the node being entered, returns true when it is past the
+		limits, which leaves timed_out set
+	*/
+	bool outOfLimits();
+
+	/**
+		Returns true once solution_limit or the limits are reached
+	*/
+	bool search(Board board);
+};
+#endif // BITBOARD_H
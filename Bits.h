@@ -0,0 +1,46 @@
+﻿#ifndef BITS_H
+#define BITS_H
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Portable wrappers for the bit scanning intrinsics
+namespace bits
+{
+	inline int32_t popcount(uint32_t x)
+	{
+#if defined(_MSC_VER)
+		return static_cast<int32_t>(__popcnt(x));
+#else
+		return __builtin_popcount(x);
+#endif
+	}
+
+	/**
+		Index of the lowest set bit, x must not be 0
+	*/
+	inline int32_t countTrailingZeros(uint32_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, x);
+		return static_cast<int32_t>(index);
+#else
+		return __builtin_ctz(x);
+#endif
+	}
+
+	inline int32_t countTrailingZeros(uint64_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, x);
+		return static_cast<int32_t>(index);
+#else
+		return __builtin_ctzll(x);
+#endif
+	}
+}
+#endif // BITS_H
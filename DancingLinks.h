@@ -0,0 +1,351 @@
+﻿#ifndef DANCING_LINKS_H
+#define DANCING_LINKS_H
+#include "Bits.h"
+
+#include <chrono>
+#include <cstdint>
+
+// Functions relating to the dancing links component of algorithmX
+namespace dl
+{
+	// Nodes refer to each other by their index into one contiguous array,
+	// which keeps the links of a node in 8 bytes and lets a matrix be copied
+	// as plain data
+	using Index = uint16_t;
+
+	// The links of a node for an index type I, matrices too large for 16
+	// bit indices use a wider one
+	template <typename I>
+	struct Links
+	{
+		I up;
+		I down;
+		I left;
+		I right;
+	};
+
+	/**
+		The row count of every column, along with a bitset per count value of
+		the uncovered columns holding that many rows and a mask of the counts
+		any uncovered column has. cover and uncover keep these up to date as
+		counts change, so the column with the fewest rows is found from the
+		lowest bits set rather than by walking the header list.
+
+		Column headers are the nodes at index 0 upwards, so count is indexed
+		by the same value as the header node of the column
+	*/
+	template <int32_t Columns, int32_t MaxCount>
+	struct Counts
+	{
+		static int32_t constexpr words = (Columns + 63) / 64;
+
+		Index count[Columns];
+		uint64_t buckets[MaxCount + 1][words];
+		Index sizes[MaxCount + 1];
+		uint32_t nonempty;
+
+		constexpr void insert(Index c)
+		{
+			Index const n = count[c];
+			buckets[n][c / 64] |= uint64_t(1) << (c % 64);
+			if (sizes[n]++ == 0)
+			{
+				nonempty |= 1u << n;
+			}
+		}
+
+		constexpr void erase(Index c)
+		{
+			Index const n = count[c];
+			buckets[n][c / 64] &= ~(uint64_t(1) << (c % 64));
+			if (--sizes[n] == 0)
+			{
+				nonempty &= ~(1u << n);
+			}
+		}
+
+		constexpr void increment(Index c)
+		{
+			erase(c);
+			++count[c];
+			insert(c);
+		}
+
+		constexpr void decrement(Index c)
+		{
+			erase(c);
+			--count[c];
+			insert(c);
+		}
+
+		/**
+			Whether c is uncovered, as covering a column erases it from its
+			bucket and only uncovering it inserts it again
+		*/
+		constexpr bool contains(Index c) const
+		{
+			return (buckets[count[c]][c / 64] >> (c % 64) & 1) != 0;
+		}
+
+		/**
+			The uncovered column with the fewest rows, the lowest index of
+			those tied, or none when every column is covered
+		*/
+		Index minimum(Index none) const
+		{
+			if (nonempty == 0)
+			{
+				return none;
+			}
+
+			uint64_t const* const bucket = buckets[bits::countTrailingZeros(nonempty)];
+			int32_t w = 0;
+			while (bucket[w] == 0)
+			{
+				++w;
+			}
+			return static_cast<Index>(w * 64 + bits::countTrailingZeros(bucket[w]));
+		}
+	};
+
+	/**
+		The column of each node is kept in col, apart from the links so a node
+		is a power of two in size and can be addressed without a multiply
+	*/
+	template <typename I, typename Counts>
+	void cover(Links<I>* nodes, I const* col, Counts& counts, I c)
+	{
+		Links<I> const& header = nodes[c];
+
+		// remove the column header
+		nodes[header.right].left = header.left;
+		nodes[header.left].right = header.right;
+		counts.erase(c);
+
+		// for each cell in the column
+		for (I i = header.down; i != c; i = nodes[i].down)
+		{
+			// and for each cell in the row, remove it
+			for (I j = nodes[i].right; j != i; j = nodes[j].right)
+			{
+				Links<I> const cell = nodes[j];
+				nodes[cell.down].up = cell.up;
+				nodes[cell.up].down = cell.down;
+				counts.decrement(col[j]);
+			}
+		}
+	}
+
+	template <typename I, typename Counts>
+	void uncover(Links<I>* nodes, I const* col, Counts& counts, I c)
+	{
+		Links<I> const& header = nodes[c];
+
+		// for each cell in the column, from bottom up
+		for (I i = header.up; i != c; i = nodes[i].up)
+		{
+			// and for each cell in the row, from left to right, add it back in
+			for (I j = nodes[i].left; j != i; j = nodes[j].left)
+			{
+				Links<I> const cell = nodes[j];
+				counts.increment(col[j]);
+				nodes[cell.down].up = j;
+				nodes[cell.up].down = j;
+			}
+		}
+
+		// add the column header back in
+		counts.insert(c);
+		nodes[header.right].left = c;
+		nodes[header.left].right = c;
+	}
+
+	/**
+		The links of a node of a matrix whose rows lie one after another
+		between spacer nodes, as in Knuth's DLX2. A row is walked by
+		stepping to the neighbouring node rather than following a right or
+		left link, a spacer sends the walk round to the other end of the
+		row, so a node takes half the memory and covers never touch the
+		headers but through counts
+	*/
+	template <typename I>
+	struct VerticalLinks
+	{
+		I up;
+		I down;
+	};
+
+	/**
+		The column of a spacer node. Its up link is the first node of the
+		row before it and its down link the last node of the row after it
+	*/
+	template <typename I>
+	constexpr I spacerColumn()
+	{
+		return static_cast<I>(~I(0));
+	}
+
+	/**
+		How the nodes of each row are linked. CircularRows link every row
+		into a ring through left and right, as in Knuth's paper, with the
+		column headers in a ring of their own
+	*/
+	struct CircularRows
+	{
+		template <typename I>
+		using Node = Links<I>;
+
+		// nodes between rows, and before the first and after the last
+		static int32_t constexpr spacers = 0;
+
+		template <typename I>
+		static I next(Links<I> const* nodes, I const*, I j)
+		{
+			return nodes[j].right;
+		}
+
+		template <typename I>
+		static I previous(Links<I> const* nodes, I const*, I j)
+		{
+			return nodes[j].left;
+		}
+	};
+
+	/**
+		SpacedRows keep each row between spacers, see VerticalLinks
+	*/
+	struct SpacedRows
+	{
+		template <typename I>
+		using Node = VerticalLinks<I>;
+
+		static int32_t constexpr spacers = 1;
+
+		template <typename I>
+		static I next(VerticalLinks<I> const* nodes, I const* col, I j)
+		{
+			++j;
+			return col[j] == spacerColumn<I>() ? nodes[j].up : j;
+		}
+
+		template <typename I>
+		static I previous(VerticalLinks<I> const* nodes, I const* col, I j)
+		{
+			--j;
+			return col[j] == spacerColumn<I>() ? nodes[j].down : j;
+		}
+	};
+
+	/**
+		cover and uncover for SpacedRows. With no header list a column is
+		only taken out of counts, which choose the column to branch on
+	*/
+	template <typename I, typename Counts>
+	void cover(VerticalLinks<I>* nodes, I const* col, Counts& counts, I c)
+	{
+		counts.erase(c);
+
+		for (I i = nodes[c].down; i != c; i = nodes[i].down)
+		{
+			for (I j = SpacedRows::next(nodes, col, i); j != i; j = SpacedRows::next(nodes, col, j))
+			{
+				VerticalLinks<I> const cell = nodes[j];
+				nodes[cell.down].up = cell.up;
+				nodes[cell.up].down = cell.down;
+				counts.decrement(col[j]);
+			}
+		}
+	}
+
+	template <typename I, typename Counts>
+	void uncover(VerticalLinks<I>* nodes, I const* col, Counts& counts, I c)
+	{
+		for (I i = nodes[c].up; i != c; i = nodes[i].up)
+		{
+			for (I j = SpacedRows::previous(nodes, col, i); j != i; j = SpacedRows::previous(nodes, col, j))
+			{
+				VerticalLinks<I> const cell = nodes[j];
+				counts.increment(col[j]);
+				nodes[cell.down].up = j;
+				nodes[cell.up].down = j;
+			}
+		}
+
+		counts.insert(c);
+	}
+}
+/**
+	Controls how much of the search tree is explored
+*/
+enum class SearchMode
+{
+	// stop as soon as a solution is found
+	FirstSolution,
+	// stop once a given number of solutions are found, a limit of 2
+	// is enough to tell whether a puzzle has a unique solution
+	CountUpTo,
+	// explore the whole tree
+	CountAll
+};
+
+/**
+	The number of solutions after which a search in mode stops
+*/
+inline uint64_t solutionLimit(SearchMode mode, uint64_t limit)
+{
+	switch (mode)
+	{
+	case SearchMode::FirstSolution:
+		return 1;
+	case SearchMode::CountUpTo:
+		return limit;
+	default:
+		return UINT64_MAX;
+	}
+}
+
+/**
+	Implementation of the search, both explore the tree in the same order
+*/
+enum class SearchEngine
+{
+	// one call per chosen row, as in Knuth's paper
+	Recursive,
+	// a loop over a fixed size stack of chosen columns and rows, its state
+	// lives in the solver so a search can be paused and resumed
+	Iterative,
+	// the iterative search of several puzzles taking turns on one thread,
+	// see BasicInterleavedSudoku, a lone solver searches iteratively
+	Interleaved
+};
+
+/**
+	Outcome of a call to loadGridAndSolve or ExactCover::solve
+*/
+struct SolveResult
+{
+	// number of solutions found before the search stopped
+	uint64_t solutions = 0;
+	// the clues contradict each other or hold a value outside 0 to size,
+	// or a row given to ExactCover was rejected, search was not run
+	bool invalid = false;
+	// the search saw its cancel flag set and stopped before finishing
+	bool cancelled = false;
+	// the search ran out of its node or time budget before finishing, the
+	// solutions found until then are still counted
+	bool timeout = false;
+	// levels of the search entered
+	uint64_t nodes = 0;
+};
+
+/**
+	Bounds on the work of a search, zero for no bound. A search stops after
+	exactly the nodes given, the time is checked every poll_interval nodes
+	of BasicSudoku or BitboardSudoku so may be overrun by that much
+*/
+struct SearchLimits
+{
+	uint64_t nodes = 0;
+	std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+};
+#endif // DANCING_LINKS_H
@@ -0,0 +1,202 @@
+﻿#include "Enumerate.h"
+
+#include <chrono>
+#include <string>
+
+namespace
+{
+	// Encoded solutions gathered before a write to the stream
+	size_t constexpr buffer_size = 1 << 20;
+
+	// The most bytes one solution takes, its lead byte and full grid
+	size_t constexpr max_entry = 1 + batch::line_length;
+
+	// The most cells a change from the solution before lists, any more
+	// and the full grid is no longer
+	int32_t constexpr max_changes = batch::line_length / 2;
+}
+
+namespace enumerate
+{
+	SolutionWriter::SolutionWriter(std::ostream& out)
+		: out(out)
+		, buffer(buffer_size)
+	{
+	}
+
+	SolutionWriter::~SolutionWriter()
+	{
+		flush();
+	}
+
+	void SolutionWriter::add(Sudoku::Grid const& solution)
+	{
+		reserve(max_entry);
+		char* const entry = &buffer[used];
+
+		// Changed cells are written after the lead byte, a solution with
+		// more than max_changes of them is written in full instead
+		int32_t changed = 0;
+		for (int32_t i = 0; i < batch::line_length && !first && changed <= max_changes; ++i)
+		{
+			if (solution[i] != previous[i])
+			{
+				if (changed < max_changes)
+				{
+					entry[1 + 2 * changed] = static_cast<char>(i);
+					entry[2 + 2 * changed] = static_cast<char>(solution[i]);
+				}
+				++changed;
+			}
+		}
+
+		if (first || changed > max_changes)
+		{
+			entry[0] = static_cast<char>(full_solution);
+			for (int32_t i = 0; i < batch::line_length; ++i)
+			{
+				entry[1 + i] = static_cast<char>(solution[i]);
+			}
+			used += max_entry;
+		}
+		else
+		{
+			entry[0] = static_cast<char>(changed);
+			used += 1 + 2 * static_cast<size_t>(changed);
+		}
+
+		previous = solution;
+		first = false;
+	}
+
+	void SolutionWriter::endPuzzle()
+	{
+		reserve(1);
+		buffer[used++] = static_cast<char>(end_of_puzzle);
+		first = true;
+	}
+
+	void SolutionWriter::flush()
+	{
+		out.write(buffer.data(), static_cast<std::streamsize>(used));
+		flushed += used;
+		used = 0;
+	}
+
+	uint64_t SolutionWriter::bytes() const
+	{
+		return flushed + used;
+	}
+
+	void SolutionWriter::reserve(size_t count)
+	{
+		if (used + count > buffer.size())
+		{
+			flush();
+		}
+	}
+
+	SolutionReader::SolutionReader(std::istream& in)
+		: in(in)
+	{
+	}
+
+	SolutionReader::Entry SolutionReader::next(Sudoku::Grid& grid)
+	{
+		int const lead = in.get();
+		if (lead == std::istream::traits_type::eof())
+		{
+			return first ? Entry::EndOfStream : Entry::Corrupt;
+		}
+
+		if (lead == end_of_puzzle)
+		{
+			first = true;
+			return Entry::EndOfPuzzle;
+		}
+
+		unsigned char bytes[2 * batch::line_length];
+		if (lead == full_solution)
+		{
+			if (!in.read(reinterpret_cast<char*>(bytes), batch::line_length))
+			{
+				return Entry::Corrupt;
+			}
+			for (int32_t i = 0; i < batch::line_length; ++i)
+			{
+				if (bytes[i] < 1 || bytes[i] > 9)
+				{
+					return Entry::Corrupt;
+				}
+				previous[i] = bytes[i];
+			}
+		}
+		else
+		{
+			// a change needs a solution before to apply to
+			if (first || lead > full_solution ||
+				!in.read(reinterpret_cast<char*>(bytes), 2 * lead))
+			{
+				return Entry::Corrupt;
+			}
+			for (int32_t k = 0; k < lead; ++k)
+			{
+				if (bytes[2 * k] >= batch::line_length || bytes[2 * k + 1] < 1 || bytes[2 * k + 1] > 9)
+				{
+					return Entry::Corrupt;
+				}
+				previous[bytes[2 * k]] = bytes[2 * k + 1];
+			}
+		}
+
+		first = false;
+		grid = previous;
+		return Entry::Solution;
+	}
+
+	EnumerateStats enumerateStream(std::istream& in, std::ostream& out, batch::BatchOptions const& options)
+	{
+		auto const start = std::chrono::steady_clock::now();
+
+		Sudoku sudoku;
+		sudoku.setEngine(options.engine);
+		sudoku.setPropagation(options.propagation);
+		sudoku.setLimits(options.limits);
+
+		SolutionWriter writer(out);
+		Sudoku::SolutionCallback const on_solution = [&writer](Sudoku::Grid const& solution)
+		{
+			writer.add(solution);
+		};
+
+		EnumerateStats stats;
+		std::string line;
+		Sudoku::Grid grid;
+
+		while (std::getline(in, line))
+		{
+			if (line.empty() || line[0] == '#' || line[0] == '\r')
+			{
+				continue;
+			}
+
+			++stats.puzzles;
+			if (!batch::parsePuzzle(line.data(), line.size(), grid))
+			{
+				++stats.malformed;
+			}
+			else
+			{
+				SolveResult const result = sudoku.loadGridAndSolve(grid, on_solution, SearchMode::CountAll);
+				stats.solutions += result.solutions;
+				stats.timeouts += result.timeout ? 1 : 0;
+			}
+			writer.endPuzzle();
+		}
+
+		writer.flush();
+		stats.bytes = writer.bytes();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+}
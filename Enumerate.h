@@ -0,0 +1,126 @@
+﻿#ifndef ENUMERATE_H
+#define ENUMERATE_H
+#include "Batch.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+	Enumerating every solution of puzzles with many, written in a compact
+	binary form so the output keeps up with the search.
+
+	The stream has one record per puzzle line, in the order of the input.
+	A record is its solutions in the order found, each led by a byte n:
+	full_solution is followed by the 81 digits of the solution as bytes 1
+	to 9, any other n from 1 to 80 by n pairs of bytes, a cell and its new
+	digit, changed from the solution before. The first solution of a record
+	is always full, a byte of end_of_puzzle ends the record. A malformed or
+	unsolvable puzzle is the end_of_puzzle byte alone.
+
+	Solutions found one after the other by the search share most of their
+	cells, so most take a few bytes rather than 82
+*/
+namespace enumerate
+{
+	static uint8_t constexpr end_of_puzzle = 0;
+	static uint8_t constexpr full_solution = static_cast<uint8_t>(batch::line_length);
+
+	/**
+		Encodes solutions to out through a buffer, written out when full and
+		by flush or the destructor
+	*/
+	class SolutionWriter
+	{
+	public:
+		explicit SolutionWriter(std::ostream& out);
+		~SolutionWriter();
+
+		SolutionWriter(SolutionWriter const&) = delete;
+		SolutionWriter& operator=(SolutionWriter const&) = delete;
+
+		/**
+			Add a solution to the record of the current puzzle
+		*/
+		void add(Sudoku::Grid const& solution);
+
+		/**
+			End the record of the current puzzle, the next solution added is
+			the first of another
+		*/
+		void endPuzzle();
+
+		void flush();
+
+		// Bytes encoded so far, whether flushed or still buffered
+		uint64_t bytes() const;
+
+	private:
+		std::ostream& out;
+		std::vector<char> buffer;
+		size_t used = 0;
+		uint64_t flushed = 0;
+
+		Sudoku::Grid previous;
+		bool first = true;
+
+		/**
+			Room for at least count more bytes in buffer
+		*/
+		void reserve(size_t count);
+	};
+
+	/**
+		Decodes a stream written by SolutionWriter
+	*/
+	class SolutionReader
+	{
+	public:
+		enum class Entry
+		{
+			// grid holds the next solution of the current puzzle
+			Solution,
+			// the current record ended, the next entry is of another puzzle
+			EndOfPuzzle,
+			// the stream ended between records
+			EndOfStream,
+			// the stream ended inside a record or holds a byte no writer
+			// produces
+			Corrupt
+		};
+
+		explicit SolutionReader(std::istream& in);
+
+		Entry next(Sudoku::Grid& grid);
+
+	private:
+		std::istream& in;
+		Sudoku::Grid previous;
+		bool first = true;
+	};
+
+	/**
+		Totals for a run of enumerateStream
+	*/
+	struct EnumerateStats
+	{
+		uint64_t puzzles = 0;
+		uint64_t solutions = 0;
+		uint64_t malformed = 0;
+		// ran out of the search limits, so their records are incomplete
+		uint64_t timeouts = 0;
+		uint64_t bytes = 0;
+		double seconds = 0.0;
+	};
+
+	/**
+		Write every solution of each puzzle line of in to out, the lines
+		read as batch::solveStream reads them. Puzzles are solved one after
+		the other by a single dancing links solver with the engine,
+		propagation and limits of options, the limits apply to each puzzle
+	*/
+	EnumerateStats enumerateStream(std::istream& in, std::ostream& out,
+		batch::BatchOptions const& options = batch::BatchOptions());
+}
+#endif // ENUMERATE_H
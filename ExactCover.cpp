@@ -0,0 +1,284 @@
+﻿#include "ExactCover.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Bytes of arena for each node, its links, column and row
+	size_t constexpr node_bytes = sizeof(dl::Links<ExactCover::Index>) +
+		sizeof(ExactCover::Index) + sizeof(int32_t);
+
+	/**
+		Row counts for dl::cover and uncover, without buckets as the column
+		with the fewest rows is found by walking the header list
+	*/
+	struct ListCounts
+	{
+		ExactCover::Index* count;
+
+		void insert(ExactCover::Index) {}
+		void erase(ExactCover::Index) {}
+
+		void increment(ExactCover::Index c)
+		{
+			++count[c];
+		}
+
+		void decrement(ExactCover::Index c)
+		{
+			--count[c];
+		}
+	};
+}
+
+ExactCover::ExactCover(int32_t primary_columns, int32_t secondary_columns,
+	int32_t cell_capacity)
+{
+	reset(primary_columns, secondary_columns, cell_capacity);
+}
+
+void ExactCover::reset(int32_t primary_columns, int32_t secondary_columns,
+	int32_t cell_capacity)
+{
+	primary_count = std::max(primary_columns, 0);
+	column_count = primary_count + std::max(secondary_columns, 0);
+	root = static_cast<Index>(column_count);
+	row_count = 0;
+	rejected = false;
+
+	size_t const headers = static_cast<size_t>(column_count) + 1;
+	size_t const wanted = headers + static_cast<size_t>(std::max(cell_capacity, 0));
+
+	if (arena_bytes < columnBytes() + wanted * node_bytes)
+	{
+		arena_bytes = columnBytes() + wanted * node_bytes;
+		arena.reset(new unsigned char[arena_bytes]);
+	}
+	carve((arena_bytes - columnBytes()) / node_bytes);
+
+	for (Index i = 0; i < headers; ++i)
+	{
+		dl::Links<Index> column;
+
+		// columns begin as only item in the column
+		column.up = i;
+		column.down = i;
+
+		// primary columns and the root form the header list, secondary
+		// columns link only to themselves so they are never chosen
+		if (i < static_cast<Index>(primary_count))
+		{
+			column.right = i + 1 == static_cast<Index>(primary_count) ? root : i + 1;
+			column.left = i == 0 ? root : i - 1;
+		}
+		else if (i == root)
+		{
+			column.right = primary_count > 0 ? 0 : root;
+			column.left = primary_count > 0 ? static_cast<Index>(primary_count - 1) : root;
+		}
+		else
+		{
+			column.right = i;
+			column.left = i;
+		}
+
+		nodes[i] = column;
+		col[i] = i;
+		row_of[i] = -1;
+		count[i] = 0;
+	}
+	node_count = headers;
+}
+
+size_t ExactCover::columnBytes() const
+{
+	return (static_cast<size_t>(column_count) + 1) * sizeof(Index) +
+		static_cast<size_t>(primary_count) * sizeof(int32_t);
+}
+
+void ExactCover::carve(size_t capacity)
+{
+	// Nodes first, as the widest, every array after is of 4 byte values
+	node_capacity = capacity;
+	nodes = reinterpret_cast<dl::Links<Index>*>(arena.get());
+	col = reinterpret_cast<Index*>(nodes + capacity);
+	row_of = reinterpret_cast<int32_t*>(col + capacity);
+	count = reinterpret_cast<Index*>(row_of + capacity);
+	solution = reinterpret_cast<int32_t*>(count + column_count + 1);
+}
+
+void ExactCover::grow(size_t capacity)
+{
+	std::unique_ptr<unsigned char[]> const old(std::move(arena));
+	dl::Links<Index> const* const old_nodes = nodes;
+	Index const* const old_col = col;
+	int32_t const* const old_row_of = row_of;
+	Index const* const old_count = count;
+
+	arena_bytes = columnBytes() + capacity * node_bytes;
+	arena.reset(new unsigned char[arena_bytes]);
+	carve(capacity);
+
+	std::copy(old_nodes, old_nodes + node_count, nodes);
+	std::copy(old_col, old_col + node_count, col);
+	std::copy(old_row_of, old_row_of + node_count, row_of);
+	std::copy(old_count, old_count + column_count + 1, count);
+}
+
+int32_t ExactCover::insertRow(int32_t const* columns, int32_t length)
+{
+	bool valid = length > 0;
+	for (int32_t i = 0; i < length && valid; ++i)
+	{
+		valid = columns[i] >= 0 && columns[i] < column_count &&
+			std::find(columns, columns + i, columns[i]) == columns + i;
+	}
+
+	if (!valid)
+	{
+		rejected = true;
+		return -1;
+	}
+
+	size_t const needed = node_count + static_cast<size_t>(length);
+	if (needed > node_capacity)
+	{
+		grow(std::max(node_capacity * 2, needed));
+	}
+
+	Index const first = static_cast<Index>(node_count);
+	Index const last = first + static_cast<Index>(length) - 1;
+
+	for (int32_t i = 0; i < length; ++i)
+	{
+		Index const index = first + static_cast<Index>(i);
+		Index const column = static_cast<Index>(columns[i]);
+		dl::Links<Index> cell;
+
+		// insert vertically
+		cell.up = nodes[column].up;
+		cell.down = column;
+
+		// insert horizontally
+		cell.right = index == last ? first : index + 1;
+		cell.left = index == first ? last : index - 1;
+
+		nodes[nodes[column].up].down = index;
+		nodes[column].up = index;
+
+		nodes[index] = cell;
+		col[index] = column;
+		row_of[index] = row_count;
+		++count[column];
+	}
+	node_count = needed;
+
+	return row_count++;
+}
+
+int32_t ExactCover::insertRow(std::initializer_list<int32_t> columns)
+{
+	return insertRow(columns.begin(), static_cast<int32_t>(columns.size()));
+}
+
+int32_t ExactCover::columnCount() const
+{
+	return column_count;
+}
+
+int32_t ExactCover::rowCount() const
+{
+	return row_count;
+}
+
+SolveResult ExactCover::solve(SolutionCallback const& callback, SearchMode mode, uint64_t limit)
+{
+	on_solution = callback ? &callback : nullptr;
+	solution_limit = solutionLimit(mode, limit);
+	solution_count = 0;
+
+	if (!rejected && solution_limit > 0)
+	{
+		search(0);
+	}
+
+	SolveResult result;
+	result.solutions = solution_count;
+	result.invalid = rejected;
+	return result;
+}
+
+void ExactCover::cover(Index c)
+{
+	ListCounts counts{ count };
+	dl::cover(nodes, col, counts, c);
+}
+
+void ExactCover::uncover(Index c)
+{
+	ListCounts counts{ count };
+	dl::uncover(nodes, col, counts, c);
+}
+
+ExactCover::Index ExactCover::chooseColumn() const
+{
+	Index best = root;
+	for (Index c = nodes[root].right; c != root; c = nodes[c].right)
+	{
+		if (best == root || count[c] < count[best])
+		{
+			best = c;
+
+			// nothing can branch less than a column with no rows
+			if (count[c] == 0)
+			{
+				break;
+			}
+		}
+	}
+	return best;
+}
+
+bool ExactCover::search(int32_t k)
+{
+	Index const c = chooseColumn();
+
+	if (c == root)
+	{
+		if (on_solution)
+		{
+			(*on_solution)(solution, k);
+		}
+		return ++solution_count >= solution_limit;
+	}
+
+	// no row can satisfy the column, so nothing below this level can be
+	// a solution
+	if (count[c] == 0)
+	{
+		return false;
+	}
+
+	cover(c);
+
+	bool stop = false;
+	for (Index r = nodes[c].down; r != c && !stop; r = nodes[r].down)
+	{
+		solution[k] = row_of[r];
+
+		for (Index j = nodes[r].right; j != r; j = nodes[j].right)
+		{
+			cover(col[j]);
+		}
+
+		stop = search(k + 1);
+
+		for (Index j = nodes[r].left; j != r; j = nodes[j].left)
+		{
+			uncover(col[j]);
+		}
+	}
+
+	uncover(c);
+	return stop;
+}
@@ -0,0 +1,142 @@
+﻿#ifndef EXACT_COVER_H
+#define EXACT_COVER_H
+#include "DancingLinks.h"
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+
+/**
+	A general exact cover solver on the same dancing links as Sudoku, for
+	problems whose matrix is only known at run time such as tilings,
+	N-queens or scheduling.
+
+	Columns 0 to primary_columns - 1 must each be covered exactly once by a
+	solution, the secondary columns numbered after them at most once. Rows
+	are added through insertRow and numbered from 0 in the order added.
+
+	Every node, column count and solution row lives in one arena allocated
+	for the matrix, so inserting rows within its capacity and searching
+	never allocate, and reset starts another problem in the same arena
+*/
+class ExactCover
+{
+public:
+	// Wider than dl::Index, as a matrix built at run time has no bound on
+	// its number of nodes
+	using Index = uint32_t;
+
+	// Receives the rows of each solution as it is found
+	using SolutionCallback = std::function<void(int32_t const* rows, int32_t count)>;
+
+	/**
+		cell_capacity sizes the arena for the rows about to be inserted,
+		the sum of their lengths, so building the matrix never reallocates
+	*/
+	ExactCover(int32_t primary_columns, int32_t secondary_columns = 0,
+		int32_t cell_capacity = 0);
+
+	// The arrays point into the arena, so a moved matrix would leave one
+	// whose sizes claim an arena it no longer has
+	ExactCover(ExactCover const&) = delete;
+	ExactCover(ExactCover&&) = delete;
+	ExactCover& operator=(ExactCover const&) = delete;
+	ExactCover& operator=(ExactCover&&) = delete;
+
+	/**
+		Empty the matrix for a problem with the given columns, as a newly
+		constructed one. The arena is kept whenever the new columns and
+		cell_capacity fit in it, only the column headers are written again
+	*/
+	void reset(int32_t primary_columns, int32_t secondary_columns = 0,
+		int32_t cell_capacity = 0);
+
+	/**
+		Add a row covering the given columns to the bottom of the matrix,
+		returning its number. A row that is empty, names a column out of
+		range or repeats one is rejected with -1 and later solves report
+		the matrix invalid
+	*/
+	int32_t insertRow(int32_t const* columns, int32_t count);
+	int32_t insertRow(std::initializer_list<int32_t> columns);
+
+	int32_t columnCount() const;
+	int32_t rowCount() const;
+
+	/**
+		Search for sets of rows covering every primary column exactly once
+		and no secondary column more than once. The matrix is restored
+		before returning, so rows can be inserted and solve called again.
+
+		limit is only used by SearchMode::CountUpTo, on_solution may be
+		empty when only the number of solutions is wanted
+	*/
+	SolveResult solve(SolutionCallback const& on_solution,
+		SearchMode mode = SearchMode::CountAll, uint64_t limit = 0);
+
+private:
+	int32_t primary_count = 0;
+	int32_t column_count = 0;
+
+	// Column headers come first in nodes followed by the root, so the root
+	// is the index of the first node past the headers
+	Index root = 0;
+
+	// The block holding every array below, carved by carve, and the nodes
+	// it has room for and those in use, headers included
+	std::unique_ptr<unsigned char[]> arena;
+	size_t arena_bytes = 0;
+	size_t node_capacity = 0;
+	size_t node_count = 0;
+
+	dl::Links<Index>* nodes = nullptr;
+	// The column and row of each node, headers have row -1
+	Index* col = nullptr;
+	int32_t* row_of = nullptr;
+	Index* count = nullptr;
+	int32_t row_count = 0;
+
+	// Every row picked covers a primary column, so a solution holds at
+	// most primary_count rows
+	int32_t* solution = nullptr;
+
+	bool rejected = false;
+
+	uint64_t solution_count = 0;
+	uint64_t solution_limit = 0;
+	SolutionCallback const* on_solution = nullptr;
+
+	/**
+		Bytes of arena taken by the column counts and the solution, which
+		are fixed by the columns, past those each node takes node_bytes
+	*/
+	size_t columnBytes() const;
+
+	/**
+		Point the arrays into arena, for capacity nodes
+	*/
+	void carve(size_t capacity);
+
+	/**
+		Move the matrix to an arena of capacity nodes, when rows are
+		inserted past the capacity given up front
+	*/
+	void grow(size_t capacity);
+
+	void cover(Index c);
+	void uncover(Index c);
+
+	/**
+		The primary column with the fewest rows left, root when every
+		primary column is covered
+	*/
+	Index chooseColumn() const;
+
+	/**
+		Algorithm X as in Sudoku::search, the rows picked so far are the
+		first k of solution
+	*/
+	bool search(int32_t k);
+};
+#endif // EXACT_COVER_H
@@ -0,0 +1,133 @@
+﻿#include "Generator.h"
+
+#include <algorithm>
+#include <numeric>
+
+template <int32_t box_size>
+BasicGenerator<box_size>::BasicGenerator()
+	: solver(new Solver())
+{
+}
+
+template <int32_t box_size>
+typename BasicGenerator<box_size>::Grid BasicGenerator<box_size>::generate(uint64_t seed, Grid* solution)
+{
+	// Every shuffle starts from the same order, so the puzzle depends only
+	// on seed and not on the puzzles generated before
+	rng.seed(seed);
+	std::iota(cells, cells + grid_size, 0);
+	std::iota(digits, digits + size, 1);
+	popClues(clue_count);
+
+	Grid full;
+	seedGrid(full);
+
+	// Add the clues of full in a random order until only full is left
+	std::shuffle(cells, cells + grid_size, rng);
+	bool done = unique();
+	for (int32_t i = 0; i < grid_size && !done; ++i)
+	{
+		if (std::find(clues, clues + clue_count, cells[i]) == clues + clue_count)
+		{
+			pushClue(cells[i], full[cells[i]]);
+			done = unique();
+		}
+	}
+
+	// Then try taking each out again, from the top of the stack down as
+	// that uncovers the fewest clues above it. A clue that must stay is
+	// pushed back on top, so the clues from required up are all needed
+	int32_t required = clue_count;
+	while (required > 0)
+	{
+		int32_t const i = required - 1;
+		int32_t const cell = clues[i];
+		removeClue(i, full);
+		--required;
+
+		if (!unique())
+		{
+			pushClue(cell, full[cell]);
+		}
+	}
+
+	Grid puzzle = {};
+	for (int32_t i = 0; i < clue_count; ++i)
+	{
+		puzzle[clues[i]] = full[clues[i]];
+	}
+
+	if (solution)
+	{
+		*solution = full;
+	}
+	return puzzle;
+}
+
+template <int32_t box_size>
+void BasicGenerator<box_size>::seedGrid(Grid& full)
+{
+	for (;;)
+	{
+		std::shuffle(cells, cells + grid_size, rng);
+		for (int32_t i = 0; i < grid_size && clue_count < seed_clues; ++i)
+		{
+			std::shuffle(digits, digits + size, rng);
+			for (int32_t d = 0; d < size; ++d)
+			{
+				if (solver->pushClue(cells[i], digits[d]))
+				{
+					clues[clue_count] = cells[i];
+					++clue_count;
+					break;
+				}
+			}
+		}
+
+		if (solver->solveClues(&full).solutions > 0)
+		{
+			return;
+		}
+		popClues(clue_count);
+	}
+}
+
+template <int32_t box_size>
+bool BasicGenerator<box_size>::unique()
+{
+	return solver->solveClues(nullptr, SearchMode::CountUpTo, 2).solutions == 1;
+}
+
+template <int32_t box_size>
+void BasicGenerator<box_size>::removeClue(int32_t i, Grid const& full)
+{
+	int32_t const above = clue_count - i - 1;
+	popClues(above + 1);
+
+	for (int32_t j = i; j < i + above; ++j)
+	{
+		clues[j] = clues[j + 1];
+		solver->pushClue(clues[j], full[clues[j]]);
+	}
+	clue_count += above;
+}
+
+template <int32_t box_size>
+void BasicGenerator<box_size>::pushClue(int32_t cell, int32_t value)
+{
+	solver->pushClue(cell, value);
+	clues[clue_count] = cell;
+	++clue_count;
+}
+
+template <int32_t box_size>
+void BasicGenerator<box_size>::popClues(int32_t count)
+{
+	for (int32_t i = 0; i < count; ++i)
+	{
+		solver->popClue();
+	}
+	clue_count -= count;
+}
+
+template class BasicGenerator<3>;
@@ -0,0 +1,78 @@
+﻿#ifndef GENERATOR_H
+#define GENERATOR_H
+#include "Sudoku.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+
+/**
+	Generates random puzzles with a unique solution that have no clue left
+	which could be removed without losing uniqueness.
+
+	A single solver is kept for the generator's lifetime with the puzzle so
+	far pushed into it as clues, so adding or removing a clue covers or
+	uncovers just that row rather than reloading the grid, and uniqueness
+	is a search counting up to two solutions. Generators share nothing, one
+	per thread generates in parallel
+*/
+template <int32_t box_size>
+class BasicGenerator
+{
+public:
+	using Solver = BasicSudoku<box_size>;
+	using Grid = typename Solver::Grid;
+
+	static int32_t constexpr size = Solver::size;
+	static int32_t constexpr grid_size = Solver::grid_size;
+
+	BasicGenerator();
+
+	/**
+		Generate the puzzle of seed, the same seed always giving the same
+		puzzle. Its solution is written to solution when it is not null
+	*/
+	Grid generate(uint64_t seed, Grid* solution = nullptr);
+
+private:
+	// Random clues pushed before the first search, enough to make the
+	// solution random rather than the first the search finds of an empty
+	// grid, few enough that they rarely leave no solution
+	static int32_t constexpr seed_clues = size + 2;
+
+	// Held by pointer for the size noted at BasicSudoku
+	std::unique_ptr<Solver> solver;
+	std::mt19937_64 rng;
+
+	// The cell of each clue pushed, in the order pushed
+	int32_t clues[grid_size];
+	int32_t clue_count = 0;
+
+	// Cells in a random order, and digits likewise
+	int32_t cells[grid_size];
+	int32_t digits[size];
+
+	/**
+		Push random clues until the solver finds a solution, writing it to
+		full
+	*/
+	void seedGrid(Grid& full);
+
+	bool unique();
+
+	/**
+		Uncover every clue pushed above index i, then clue i itself, and
+		push the clues above it back, leaving clue i out of the puzzle
+	*/
+	void removeClue(int32_t i, Grid const& full);
+
+	void pushClue(int32_t cell, int32_t value);
+	void popClues(int32_t count);
+};
+
+// Only 9x9 is instantiated, as the searches proving sparse 16x16 puzzles
+// unique can take minutes each
+using Generator = BasicGenerator<3>;
+
+extern template class BasicGenerator<3>;
+#endif // GENERATOR_H
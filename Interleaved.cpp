@@ -0,0 +1,87 @@
+﻿#include "Interleaved.h"
+
+template <int32_t box_size>
+BasicInterleavedSudoku<box_size>::BasicInterleavedSudoku()
+	: solvers(ways)
+{
+	for (Solver& solver : solvers)
+	{
+		solver.setEngine(SearchEngine::Iterative);
+	}
+}
+
+template <int32_t box_size>
+void BasicInterleavedSudoku<box_size>::setPropagation(bool enabled)
+{
+	for (Solver& solver : solvers)
+	{
+		solver.setPropagation(enabled);
+	}
+}
+
+template <int32_t box_size>
+void BasicInterleavedSudoku<box_size>::setLimits(SearchLimits const& limits)
+{
+	for (Solver& solver : solvers)
+	{
+		solver.setLimits(limits);
+	}
+}
+
+template <int32_t box_size>
+void BasicInterleavedSudoku<box_size>::solveAll(Grid const* const* puzzles, Grid* const* solutions,
+	SolveResult* results, size_t count, SearchMode mode, uint64_t limit)
+{
+	// The puzzle each solver is searching, count when it is idle
+	size_t searching[ways];
+	size_t next = 0;
+	size_t active = 0;
+
+	// Start the next puzzle that needs a search on solver w, finishing any
+	// that don't straight away
+	auto const start = [&](size_t w)
+	{
+		searching[w] = count;
+		while (next < count)
+		{
+			size_t const i = next++;
+			if (solvers[w].startSolve(*puzzles[i], solutions[i], mode, limit))
+			{
+				searching[w] = i;
+				++active;
+				return;
+			}
+			results[i] = solvers[w].finishSolve();
+		}
+	};
+
+	for (size_t w = 0; w < ways; ++w)
+	{
+		start(w);
+	}
+
+	while (active > 0)
+	{
+		for (size_t w = 0; w < ways; ++w)
+		{
+			size_t const i = searching[w];
+			if (i != count && solvers[w].advance(turn_steps))
+			{
+				results[i] = solvers[w].finishSolve();
+				--active;
+				start(w);
+			}
+		}
+	}
+}
+
+template <int32_t box_size>
+SolveResult BasicInterleavedSudoku<box_size>::loadGridAndSolve(Grid const& grid, Grid* solution,
+	SearchMode mode, uint64_t limit)
+{
+	return solvers[0].loadGridAndSolve(grid, solution, mode, limit);
+}
+
+template class BasicInterleavedSudoku<3>;
+template class BasicInterleavedSudoku<4>;
+template class BasicInterleavedSudoku<5>;
@@ -0,0 +1,59 @@
+﻿#ifndef INTERLEAVED_H
+#define INTERLEAVED_H
+#include "Sudoku.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+	Searches several puzzles on one thread at once, each on a solver of its
+	own taking turns of a few levels of the iterative search. A single
+	search is a chain of dependent loads through the links, the turns of
+	the others give the processor independent work to overlap with them.
+
+	Results are the same as a BasicSudoku with the iterative engine gives
+	for each puzzle
+*/
+template <int32_t box_size>
+class BasicInterleavedSudoku
+{
+public:
+	using Solver = BasicSudoku<box_size>;
+	using Grid = typename Solver::Grid;
+
+	// Searches in flight at once
+	static size_t constexpr ways = 4;
+
+	// Levels a search advances each turn
+	static uint64_t constexpr turn_steps = 4;
+
+	BasicInterleavedSudoku();
+
+	void setPropagation(bool enabled);
+	void setLimits(SearchLimits const& limits);
+
+	/**
+		Solve puzzles[i] for every i below count taking turns, writing its
+		first solution to solutions[i] and its result to results[i]
+	*/
+	void solveAll(Grid const* const* puzzles, Grid* const* solutions, SolveResult* results,
+		size_t count, SearchMode mode = SearchMode::FirstSolution, uint64_t limit = 0);
+
+	/**
+		Solve a lone puzzle, as there is nothing to take turns with
+	*/
+	SolveResult loadGridAndSolve(Grid const& grid, Grid* solution,
+		SearchMode mode = SearchMode::FirstSolution, uint64_t limit = 0);
+
+private:
+	// In a vector for the size noted at BasicSudoku
+	std::vector<Solver> solvers;
+};
+
+using InterleavedSudoku = BasicInterleavedSudoku<3>;
+
+extern template class BasicInterleavedSudoku<3>;
+extern template class BasicInterleavedSudoku<4>;
+extern template class BasicInterleavedSudoku<5>;
+#endif // INTERLEAVED_H
@@ -0,0 +1,210 @@
+﻿#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Enough subproblems per thread that one slow branch is not left
+	// running alone at the end while the other threads sit idle
+	size_t constexpr subproblems_per_thread = 8;
+
+	// Branches tried per subproblem wanted before searching what is open,
+	// a tree still that narrow is searched sooner than it is split
+	size_t constexpr expansion_per_subproblem = 4;
+}
+
+namespace parallel
+{
+	template <int32_t box_size>
+	SolveResult solve(BasicSudoku<box_size> const& solver,
+		typename BasicSudoku<box_size>::Grid const& grid,
+		typename BasicSudoku<box_size>::Grid* solution,
+		SearchMode mode, uint64_t limit, int32_t threads)
+	{
+		using Grid = typename BasicSudoku<box_size>::Grid;
+		using Clock = std::chrono::steady_clock;
+
+		// The limits of solver bound the whole search, each subproblem is
+		// given what is left of them
+		SearchLimits const limits = solver.limits();
+		Clock::time_point const start = Clock::now();
+
+		// Copies of the solver for every thread, in a vector for the size
+		// noted at BasicSudoku
+		std::vector<BasicSudoku<box_size>> solvers(static_cast<size_t>(std::max(threads, 1)), solver);
+
+		SolveResult result;
+		uint64_t const solution_limit = solutionLimit(mode, limit);
+
+		// Expand the tree breadth first until every thread has enough
+		// subproblems, none of them branches any further or the branches
+		// allowed run out. Filled grids are set aside in subproblems as
+		// they are, the rest wait in open
+		std::vector<Grid> subproblems;
+		std::deque<Grid> open;
+		{
+			std::vector<Grid> children;
+			if (!solvers[0].branch(grid, children))
+			{
+				result.invalid = true;
+				return result;
+			}
+			open.assign(children.begin(), children.end());
+		}
+
+		size_t const wanted = solvers.size() * subproblems_per_thread;
+		size_t branches = 0;
+		std::vector<Grid> children;
+		while (!open.empty() && open.size() + subproblems.size() < wanted &&
+			branches < wanted * expansion_per_subproblem)
+		{
+			Grid subproblem = open.front();
+			open.pop_front();
+
+			// A column with a single row forces it, so it is filled in
+			// place rather than spending a split on one child
+			for (;;)
+			{
+				children.clear();
+				solvers[0].branch(subproblem, children);
+				++branches;
+				if (children.size() != 1 || children[0] == subproblem)
+				{
+					break;
+				}
+				subproblem = children[0];
+			}
+
+			if (children.size() == 1)
+			{
+				subproblems.push_back(subproblem);
+			}
+			else
+			{
+				open.insert(open.end(), children.begin(), children.end());
+			}
+		}
+		subproblems.insert(subproblems.end(), open.begin(), open.end());
+
+		if (solution_limit == 0)
+		{
+			return result;
+		}
+
+		std::atomic<size_t> cursor(0);
+		std::atomic<uint64_t> found(0);
+		std::atomic<uint64_t> nodes(0);
+		std::atomic<bool> timeout(false);
+		std::atomic<bool> cancel(false);
+		// A caller cancelling through its own flag still stops every thread
+		std::atomic<bool> const* const caller_cancel = solver.cancelFlag();
+
+		std::mutex solution_lock;
+		bool solution_written = false;
+
+		auto const work = [&](size_t worker)
+		{
+			BasicSudoku<box_size>& sudoku = solvers[worker];
+			sudoku.setCancelFlag(&cancel, caller_cancel);
+
+			Grid local;
+			while (!cancel.load(std::memory_order_relaxed))
+			{
+				size_t const i = cursor.fetch_add(1);
+				if (i >= subproblems.size())
+				{
+					break;
+				}
+
+				// Counting no further than the solutions still missing, should
+				// that many be found the limit is reached whatever the
+				// subproblems still running find
+				uint64_t const remaining = solution_limit - std::min(found.load(), solution_limit);
+
+				SearchLimits left;
+				if (limits.nodes != 0)
+				{
+					left.nodes = limits.nodes - std::min(nodes.load(), limits.nodes);
+				}
+				if (limits.time != Clock::duration::zero())
+				{
+					left.time = limits.time - (Clock::now() - start);
+				}
+
+				if ((limits.nodes != 0 && left.nodes == 0) ||
+					(limits.time != Clock::duration::zero() && left.time <= Clock::duration::zero()))
+				{
+					timeout.store(true);
+					cancel.store(true, std::memory_order_relaxed);
+					break;
+				}
+				sudoku.setLimits(left);
+
+				SolveResult const partial = sudoku.loadGridAndSolve(subproblems[i],
+					solution ? &local : nullptr, SearchMode::CountUpTo, remaining);
+
+				nodes.fetch_add(partial.nodes);
+				if (partial.cancelled)
+				{
+					cancel.store(true, std::memory_order_relaxed);
+				}
+				if (partial.timeout)
+				{
+					timeout.store(true);
+					cancel.store(true, std::memory_order_relaxed);
+				}
+
+				if (partial.solutions == 0)
+				{
+					continue;
+				}
+
+				if (solution)
+				{
+					std::lock_guard<std::mutex> const guard(solution_lock);
+					if (!solution_written)
+					{
+						*solution = local;
+						solution_written = true;
+					}
+				}
+
+				if (found.fetch_add(partial.solutions) + partial.solutions >= solution_limit)
+				{
+					cancel.store(true, std::memory_order_relaxed);
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t worker = 1; worker < solvers.size(); ++worker)
+		{
+			workers.emplace_back(work, worker);
+		}
+		work(0);
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		result.solutions = std::min(found.load(), solution_limit);
+		result.timeout = timeout.load() && result.solutions < solution_limit;
+		result.cancelled = caller_cancel && caller_cancel->load() && result.solutions < solution_limit;
+		result.nodes = nodes.load();
+		return result;
+	}
+
+	template SolveResult solve<3>(Sudoku const&, Sudoku::Grid const&, Sudoku::Grid*,
+		SearchMode, uint64_t, int32_t);
+	template SolveResult solve<4>(Sudoku16 const&, Sudoku16::Grid const&, Sudoku16::Grid*,
+		SearchMode, uint64_t, int32_t);
+	template SolveResult solve<5>(Sudoku25 const&, Sudoku25::Grid const&, Sudoku25::Grid*,
+		SearchMode, uint64_t, int32_t);
+}
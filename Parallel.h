@@ -0,0 +1,31 @@
+﻿#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "Sudoku.h"
+
+#include <cstdint>
+
+// Searching a single puzzle with several threads
+namespace parallel
+{
+	/**
+		Solve grid by splitting it with BasicSudoku::branch into a few
+		subproblems per thread, filling in forced cells without counting
+		them as a split, which threads then take from a shared cursor and
+		search on their own copy of solver, so its engine and propagation
+		settings apply. A tree too narrow to give that many within a
+		bounded number of branches is searched from what it gave. Once the solution limit of mode is
+		reached the other threads are cancelled. The limits of solver bound
+		the nodes and time of all threads together, and its cancel flag
+		stops all of them.
+
+		Counts are the same as a single solver gives. When several solutions
+		exist, which one is written to solution depends on the threads
+		finishing first
+	*/
+	template <int32_t box_size>
+	SolveResult solve(BasicSudoku<box_size> const& solver,
+		typename BasicSudoku<box_size>::Grid const& grid,
+		typename BasicSudoku<box_size>::Grid* solution,
+		SearchMode mode, uint64_t limit, int32_t threads);
+}
+#endif // PARALLEL_H
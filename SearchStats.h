@@ -0,0 +1,123 @@
+﻿#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+#include <chrono>
+#include <cstdint>
+
+/**
+	Stats policy of BasicSudoku recording nothing, the default, so the
+	calls made by search compile away
+*/
+struct NoStats
+{
+	void node() {}
+	void branch(int32_t, int32_t) {}
+	void cover(int32_t) {}
+	void uncover(int32_t) {}
+
+	void beginLoad() {}
+	void beginSearch() {}
+	void endSearch() {}
+	void endLoad() {}
+};
+
+/**
+	Stats policy of BasicSudoku totalling the work of every search made
+	since the solver was constructed or its stats cleared, for telling why
+	a puzzle is slow or ranking puzzles by difficulty
+*/
+template <int32_t box_size>
+struct SearchStats
+{
+	using Clock = std::chrono::steady_clock;
+
+	static int32_t constexpr size = box_size * box_size;
+	static int32_t constexpr max_depth = size * size;
+
+	// levels of the search entered
+	uint64_t nodes = 0;
+	uint64_t covers = 0;
+	uint64_t uncovers = 0;
+	// writes to up, down, left or right made by covers and uncovers
+	uint64_t links = 0;
+
+	// branching[k][n] counts the levels at depth k that branched on a
+	// column of n rows, depth counting the clues
+	uint64_t branching[max_depth + 1][size + 1] = {};
+
+	// covering and uncovering the clues, and the search between
+	Clock::duration load_time = Clock::duration::zero();
+	Clock::duration search_time = Clock::duration::zero();
+	Clock::time_point mark;
+
+	void node()
+	{
+		++nodes;
+	}
+
+	void branch(int32_t depth, int32_t rows)
+	{
+		++branching[depth][rows];
+	}
+
+	/**
+		A column is covered or uncovered with cells taken out of, or put
+		back into, the other columns, two links for each and two for the
+		header
+	*/
+	void cover(int32_t cells)
+	{
+		++covers;
+		links += 2 + 2 * static_cast<uint64_t>(cells);
+	}
+
+	void uncover(int32_t cells)
+	{
+		++uncovers;
+		links += 2 + 2 * static_cast<uint64_t>(cells);
+	}
+
+	void beginLoad()
+	{
+		mark = Clock::now();
+	}
+
+	void beginSearch()
+	{
+		Clock::time_point const now = Clock::now();
+		load_time += now - mark;
+		mark = now;
+	}
+
+	void endSearch()
+	{
+		Clock::time_point const now = Clock::now();
+		search_time += now - mark;
+		mark = now;
+	}
+
+	void endLoad()
+	{
+		load_time += Clock::now() - mark;
+	}
+
+	/**
+		Add the totals of other, as when combining the stats of workers
+	*/
+	void merge(SearchStats const& other)
+	{
+		nodes += other.nodes;
+		covers += other.covers;
+		uncovers += other.uncovers;
+		links += other.links;
+		for (int32_t k = 0; k <= max_depth; ++k)
+		{
+			for (int32_t n = 0; n <= size; ++n)
+			{
+				branching[k][n] += other.branching[k][n];
+			}
+		}
+		load_time += other.load_time;
+		search_time += other.search_time;
+	}
+};
+#endif // SEARCH_STATS_H
@@ -0,0 +1,406 @@
+﻿#include "Server.h"
+#include "Bitboard.h"
+#include "Sudoku.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Requests read from a connection at most at once, larger pipelines
+	// are solved as several batches
+	size_t constexpr max_batch = 4096;
+
+	// Requests in a batch for each solver working on it, below that
+	// handing a slice to another thread costs more than it saves
+	size_t constexpr requests_per_solver = 64;
+
+	// Pause after accept fails for want of descriptors or memory, rather
+	// than retrying at once while nothing has been freed
+	std::chrono::milliseconds constexpr accept_backoff(100);
+
+	struct Solvers
+	{
+		Sudoku dancing_links;
+		SpacedSudoku spaced;
+		BitboardSudoku bitboard;
+
+		// A slice of a batch handed to the thread of these solvers, set
+		// until it has been run
+		std::function<void(size_t)> const* work = nullptr;
+		size_t slice = 0;
+	};
+
+	/**
+		The warm solvers of a server, which batches borrow and hand back,
+		each with a thread of its own kept for the life of the pool
+	*/
+	class Pool
+	{
+	public:
+		explicit Pool(batch::BatchOptions const& batch_options)
+			: options(batch_options)
+			, solvers(static_cast<size_t>(std::max(batch_options.threads, 1)))
+		{
+			for (Solvers& solver : solvers)
+			{
+				solver.dancing_links.setEngine(options.engine);
+				solver.dancing_links.setPropagation(options.propagation);
+				solver.dancing_links.setLimits(options.limits);
+				solver.spaced.setEngine(options.engine);
+				solver.spaced.setPropagation(options.propagation);
+				solver.spaced.setLimits(options.limits);
+				solver.bitboard.setLimits(options.limits);
+				idle.push_back(&solver);
+				threads.emplace_back(&Pool::runSlices, this, std::ref(solver));
+			}
+		}
+
+		~Pool()
+		{
+			{
+				std::lock_guard<std::mutex> const guard(lock);
+				stopping = true;
+			}
+			handed.notify_all();
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		/**
+			Take between one and wanted solvers, waiting while none is idle
+		*/
+		void acquire(size_t wanted, std::vector<Solvers*>& taken)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			available.wait(guard, [this]() { return !idle.empty(); });
+
+			size_t const count = std::min(std::max<size_t>(wanted, 1), idle.size());
+			taken.assign(idle.end() - count, idle.end());
+			idle.resize(idle.size() - count);
+		}
+
+		void release(std::vector<Solvers*> const& taken)
+		{
+			{
+				std::lock_guard<std::mutex> const guard(lock);
+				idle.insert(idle.end(), taken.begin(), taken.end());
+			}
+			available.notify_all();
+		}
+
+		/**
+			Call work with every slice i below taken.size(), slice i on the
+			thread of taken[i] and the first on the calling thread, and
+			return once all are done
+		*/
+		void run(std::vector<Solvers*> const& taken, std::function<void(size_t)> const& work)
+		{
+			{
+				std::lock_guard<std::mutex> const guard(lock);
+				for (size_t i = 1; i < taken.size(); ++i)
+				{
+					taken[i]->work = &work;
+					taken[i]->slice = i;
+				}
+			}
+			handed.notify_all();
+
+			work(0);
+
+			std::unique_lock<std::mutex> guard(lock);
+			finished.wait(guard, [&taken]()
+			{
+				return std::all_of(taken.begin() + 1, taken.end(),
+					[](Solvers const* solver) { return solver->work == nullptr; });
+			});
+		}
+
+		batch::BatchOptions const options;
+
+	private:
+		std::vector<Solvers> solvers;
+		std::vector<Solvers*> idle;
+		std::vector<std::thread> threads;
+		bool stopping = false;
+		std::mutex lock;
+		std::condition_variable available;
+		std::condition_variable handed;
+		std::condition_variable finished;
+
+		void runSlices(Solvers& solver)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			for (;;)
+			{
+				handed.wait(guard, [&]() { return stopping || solver.work; });
+				if (!solver.work)
+				{
+					return;
+				}
+
+				std::function<void(size_t)> const& work = *solver.work;
+				guard.unlock();
+				work(solver.slice);
+				guard.lock();
+
+				solver.work = nullptr;
+				finished.notify_all();
+			}
+		}
+	};
+
+	server::Status statusOf(SolveResult const& result)
+	{
+		if (result.timeout && result.solutions < 2)
+		{
+			return server::Status::Timeout;
+		}
+		if (result.solutions == 0)
+		{
+			return server::Status::None;
+		}
+		return result.solutions == 1 ? server::Status::Unique : server::Status::Multiple;
+	}
+
+	void solveRequest(Solvers& solvers, batch::BatchOptions const& options, char const* request,
+		char* reply)
+	{
+		Sudoku::Grid puzzle;
+		Sudoku::Grid solution;
+
+		// Counting to two tells a unique solution from one of several
+		SolveResult result;
+		server::Status status = server::Status::Malformed;
+		if (batch::parsePuzzle(request, server::request_size, puzzle))
+		{
+			if (options.backend == batch::Backend::Bitboard)
+			{
+				result = solvers.bitboard.loadGridAndSolve(puzzle, &solution, SearchMode::CountUpTo, 2);
+			}
+			else if (options.backend == batch::Backend::SpacedLinks)
+			{
+				result = solvers.spaced.loadGridAndSolve(puzzle, &solution, SearchMode::CountUpTo, 2);
+			}
+			else
+			{
+				result = solvers.dancing_links.loadGridAndSolve(puzzle, &solution, SearchMode::CountUpTo, 2);
+			}
+			status = statusOf(result);
+		}
+
+		if (result.solutions > 0)
+		{
+			batch::formatGrid(solution, reply);
+		}
+		else
+		{
+			std::memset(reply, '.', batch::line_length);
+		}
+		reply[batch::line_length] = static_cast<char>(status);
+	}
+
+	/**
+		Solve count requests into replies, on as many borrowed solvers as
+		the batch is worth, the calling thread working with the first
+	*/
+	void solveBatch(Pool& pool, char const* requests, char* replies, size_t count)
+	{
+		std::vector<Solvers*> taken;
+		pool.acquire((count + requests_per_solver - 1) / requests_per_solver, taken);
+
+		std::function<void(size_t)> const work = [&](size_t worker)
+		{
+			// contiguous slices, as every request costs about the same
+			size_t const begin = count * worker / taken.size();
+			size_t const end = count * (worker + 1) / taken.size();
+			for (size_t i = begin; i < end; ++i)
+			{
+				solveRequest(*taken[worker], pool.options, requests + i * server::request_size,
+					replies + i * server::reply_size);
+			}
+		};
+		pool.run(taken, work);
+
+		pool.release(taken);
+	}
+
+#if !defined(_WIN32)
+	bool writeAll(int fd, char const* data, size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t const written = write(fd, data, size);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	/**
+		Answer requests of in_fd until its end. A read returns whatever has
+		arrived, so a lone request is answered at once while a full pipeline
+		is solved as one batch
+	*/
+	bool serveConnection(Pool& pool, int in_fd, int out_fd)
+	{
+		std::vector<char> requests(max_batch * server::request_size);
+		std::vector<char> replies(max_batch * server::reply_size);
+		size_t buffered = 0;
+
+		for (;;)
+		{
+			ssize_t const got = read(in_fd, requests.data() + buffered, requests.size() - buffered);
+			if (got < 0)
+			{
+				// a signal arriving before any data is not an error
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			if (got == 0)
+			{
+				// a partial request left at the end is dropped
+				return true;
+			}
+			buffered += static_cast<size_t>(got);
+
+			size_t const count = buffered / server::request_size;
+			if (count == 0)
+			{
+				continue;
+			}
+
+			solveBatch(pool, requests.data(), replies.data(), count);
+			if (!writeAll(out_fd, replies.data(), count * server::reply_size))
+			{
+				return false;
+			}
+
+			// keep the start of a request split across reads
+			size_t const used = count * server::request_size;
+			std::memmove(requests.data(), requests.data() + used, buffered - used);
+			buffered -= used;
+		}
+	}
+#endif
+}
+
+namespace server
+{
+	bool serve(int in_fd, int out_fd, batch::BatchOptions const& options)
+	{
+#if defined(_WIN32)
+		(void)in_fd;
+		(void)out_fd;
+		(void)options;
+		return false;
+#else
+		Pool pool(options);
+		return serveConnection(pool, in_fd, out_fd);
+#endif
+	}
+
+	bool listen(char const* path, batch::BatchOptions const& options)
+	{
+#if defined(_WIN32)
+		(void)path;
+		(void)options;
+		return false;
+#else
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (std::strlen(path) >= sizeof(address.sun_path))
+		{
+			return false;
+		}
+		std::strcpy(address.sun_path, path);
+
+		int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		// Only a socket left by an earlier server is replaced, any other
+		// file at path is not ours to delete
+		struct stat info;
+		if (lstat(path, &info) == 0)
+		{
+			if (!S_ISSOCK(info.st_mode))
+			{
+				close(fd);
+				return false;
+			}
+			unlink(path);
+		}
+
+		if (bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 ||
+			::listen(fd, SOMAXCONN) != 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		// A client closing early fails the write rather than ending the server
+		std::signal(SIGPIPE, SIG_IGN);
+
+		Pool pool(options);
+		for (;;)
+		{
+			int const client = accept(fd, nullptr, nullptr);
+			if (client < 0)
+			{
+				if (errno == EINTR || errno == ECONNABORTED)
+				{
+					continue;
+				}
+
+				// out of descriptors or memory until a connection closes
+				if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+				{
+					std::this_thread::sleep_for(accept_backoff);
+					continue;
+				}
+
+				close(fd);
+				return false;
+			}
+
+			std::thread([&pool, client]()
+			{
+				serveConnection(pool, client, client);
+				close(client);
+			}).detach();
+		}
+#endif
+	}
+}
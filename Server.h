@@ -0,0 +1,57 @@
+﻿#ifndef SERVER_H
+#define SERVER_H
+#include "Batch.h"
+
+#include <cstddef>
+
+/**
+	A long running solver answering fixed size binary requests, so callers
+	pay for the search alone rather than a process start per puzzle.
+
+	A request is the 81 characters of a puzzle as batch::parsePuzzle reads
+	them, with no separator. Each is answered in order by 82 bytes, the
+	solution as 81 digits, or 81 '.' when there is none, followed by a
+	Status byte. Requests may be pipelined, whatever has arrived is solved
+	as one batch over a pool of solvers kept warm for the life of the server
+*/
+namespace server
+{
+	// Bytes of a request and of its reply
+	static size_t constexpr request_size = batch::line_length;
+	static size_t constexpr reply_size = batch::line_length + 1;
+
+	/**
+		The last byte of a reply, printable so replies can be read by eye
+	*/
+	enum class Status : char
+	{
+		Unique = 'U',
+		// the solution is one of several
+		Multiple = 'M',
+		// contradicting clues or no solution
+		None = 'N',
+		// ran out of the search limits, the solution is given if one was
+		// found before but may not be unique
+		Timeout = 'T',
+		// not a puzzle in the 81 character format
+		Malformed = 'X'
+	};
+
+	/**
+		Answer the requests read from in_fd on out_fd until in_fd reaches its
+		end, with options.threads solvers of options.backend, dancing links
+		for Backend::Routed, and no cache. Returns false on a read or write
+		error. Always false where POSIX file descriptors aren't available
+	*/
+	bool serve(int in_fd, int out_fd, batch::BatchOptions const& options);
+
+	/**
+		Listen on a Unix socket at path, replacing a socket already there,
+		serving each connection on its own thread from one shared pool of
+		options.threads solvers. Only returns, false, when the socket can't
+		be set up, path holds a file other than a socket, or accepting
+		fails for a reason other than running out of descriptors
+	*/
+	bool listen(char const* path, batch::BatchOptions const& options);
+}
+#endif // SERVER_H
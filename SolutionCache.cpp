@@ -0,0 +1,95 @@
+﻿#include "SolutionCache.h"
+
+#include <algorithm>
+
+namespace
+{
+	// FNV-1a
+	uint64_t hashOf(SolutionCache::Packed const& key)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (uint8_t const byte : key)
+		{
+			hash = (hash ^ byte) * 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+SolutionCache::SolutionCache(size_t capacity)
+	: shard_capacity(std::max<size_t>((capacity + shard_count - 1) / shard_count, 1))
+	, shards(new Shard[shard_count])
+{
+}
+
+bool SolutionCache::find(Sudoku::Grid const& puzzle, Entry& entry)
+{
+	Packed const key = pack(puzzle);
+	Shard& shard = shardOf(key);
+
+	std::lock_guard<std::mutex> const guard(shard.lock);
+	auto const found = shard.index.find(key);
+	if (found == shard.index.end())
+	{
+		return false;
+	}
+
+	shard.order.splice(shard.order.begin(), shard.order, found->second);
+	entry = found->second->second;
+	return true;
+}
+
+void SolutionCache::insert(Sudoku::Grid const& puzzle, Entry const& entry)
+{
+	Packed const key = pack(puzzle);
+	Shard& shard = shardOf(key);
+
+	std::lock_guard<std::mutex> const guard(shard.lock);
+	auto const found = shard.index.find(key);
+	if (found != shard.index.end())
+	{
+		// another thread solved the same puzzle first
+		shard.order.splice(shard.order.begin(), shard.order, found->second);
+		return;
+	}
+
+	if (shard.index.size() >= shard_capacity)
+	{
+		shard.index.erase(shard.order.back().first);
+		shard.order.pop_back();
+	}
+
+	shard.order.emplace_front(key, entry);
+	shard.index.emplace(key, shard.order.begin());
+}
+
+SolutionCache::Packed SolutionCache::pack(Sudoku::Grid const& grid)
+{
+	Packed packed;
+	for (int32_t i = 0; i < Sudoku::grid_size; ++i)
+	{
+		packed[i] = static_cast<uint8_t>(grid[i]);
+	}
+	return packed;
+}
+
+Sudoku::Grid SolutionCache::unpack(Packed const& packed)
+{
+	Sudoku::Grid grid;
+	for (int32_t i = 0; i < Sudoku::grid_size; ++i)
+	{
+		grid[i] = packed[i];
+	}
+	return grid;
+}
+
+size_t SolutionCache::Hash::operator()(Packed const& key) const
+{
+	return static_cast<size_t>(hashOf(key));
+}
+
+SolutionCache::Shard& SolutionCache::shardOf(Packed const& key)
+{
+	// the top bits, as the map buckets use the bottom ones
+	return shards[(hashOf(key) >> 56) % shard_count];
+}
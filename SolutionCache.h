@@ -0,0 +1,76 @@
+﻿#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+#include "Sudoku.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+	A bounded map from puzzles to the result of solving them, evicting the
+	least recently used entry once full, which any number of threads can
+	share. Entries are spread over shards each with its own lock and order,
+	so threads rarely wait on one another. Meant to be keyed on canonical
+	puzzles, see symmetry::canonicalize, so equivalent puzzles share an entry
+*/
+class SolutionCache
+{
+public:
+	// A grid with a byte per cell
+	using Packed = std::array<uint8_t, Sudoku::grid_size>;
+
+	struct Entry
+	{
+		// false when the puzzle has no solution, solution is then unused
+		bool solved = false;
+		Packed solution;
+	};
+
+	/**
+		Hold at most capacity entries, at least one per shard
+	*/
+	explicit SolutionCache(size_t capacity);
+
+	/**
+		Set entry to the result stored for puzzle, marking it most recently
+		used. Returns false when there is none
+	*/
+	bool find(Sudoku::Grid const& puzzle, Entry& entry);
+
+	/**
+		Store entry as the result of puzzle, evicting the least recently
+		used entry of its shard when that is full
+	*/
+	void insert(Sudoku::Grid const& puzzle, Entry const& entry);
+
+	static Packed pack(Sudoku::Grid const& grid);
+	static Sudoku::Grid unpack(Packed const& packed);
+
+private:
+	static size_t constexpr shard_count = 16;
+
+	struct Hash
+	{
+		size_t operator()(Packed const& key) const;
+	};
+
+	struct Shard
+	{
+		using Order = std::list<std::pair<Packed, Entry>>;
+
+		std::mutex lock;
+		// most recently used first
+		Order order;
+		std::unordered_map<Packed, Order::iterator, Hash> index;
+	};
+
+	size_t shard_capacity;
+	std::unique_ptr<Shard[]> shards;
+
+	Shard& shardOf(Packed const& key);
+};
+#endif // SOLUTION_CACHE_H
@@ -12,254 +12,851 @@
 */
 #include "Sudoku.h"
 
-#include <cstdint>
-#include <iostream>
+#include <algorithm>
 #include <array>
+#include <cstdint>
 
-int main()
+template <int32_t box_size, typename Rows>
+constexpr typename SudokuMatrix<box_size, Rows>::Prebuilt SudokuMatrix<box_size, Rows>::build()
 {
-	Sudoku sudoku;
+	Prebuilt built{};
+	Node* const nodes = built.matrix.nodes;
+
+	// construct columns for dancing links
+	for (int32_t i = 0; i < column_size; ++i)
+	{
+		Node& column = nodes[i];
+
+		// columns begin as only item in the column
+		column.up = static_cast<dl::Index>(i);
+		column.down = static_cast<dl::Index>(i);
+		linkHeader(column, i);
+
+		// set metadata
+		built.col[i] = static_cast<dl::Index>(i);
+		built.matrix.counts.count[i] = 0;
+		if (i != root)
+		{
+			built.matrix.counts.insert(static_cast<dl::Index>(i));
+		}
+	}
 
-	// 19/02/2022 NYTimes hard sudoku
-	std::vector<std::vector<int32_t>> const grid = {
-		{0,7,0, 4,8,0, 1,3,0},
-		{0,0,0, 0,0,0, 0,0,0},
-		{0,0,0, 5,6,0, 0,8,0},
+	// Construct all rows, 729 for a 9x9 grid, each column should have size items
+	for (int32_t i = 0; i < row_size; ++i)
+	{
+		int32_t const col = (i / size) % size;
+		int32_t const row = i / grid_size;
+		int32_t const num = i % size;
 
-		{0,6,0, 0,0,8, 0,7,0},
-		{0,4,1, 0,0,6, 0,0,0},
-		{0,0,8, 0,0,0, 0,1,0},
+		int32_t const col_block_group = col / box_size;
+		int32_t const row_block_group = row / box_size;
 
-		{0,9,0, 3,0,0, 2,0,8},
-		{0,0,5, 0,0,2, 0,0,0},
-		{4,0,0, 0,7,0, 5,0,0}
-	};
+		int32_t const cell_constraint = i / size;
+		int32_t const row_constraint = (row * size) + num;
+		int32_t const column_constraint = i % grid_size;
+		int32_t const block_constraint = (row_block_group * box_size + col_block_group) * size + num;
 
-	sudoku.loadGridAndSolve(grid);
+		insertRow(built, i, { cell_constraint, grid_size + row_constraint,
+			2 * grid_size + column_constraint, 3 * grid_size + block_constraint });
+	}
 
-	return 0;
+	return built;
 }
 
-namespace dl
+/**
+	Function for inserting a row into the bottom of the dancing links matrix
+*/
+template <int32_t box_size, typename Rows>
+constexpr void SudokuMatrix<box_size, Rows>::insertRow(Prebuilt& built, int32_t row, std::array<int32_t, cells_per_row> const& items)
 {
-	// Cover a column
-	void cover(Column* cell)
+	Node* const nodes = built.matrix.nodes;
+
+	for (int32_t i = 0; i < cells_per_row; ++i)
 	{
-		// remove the column header
-		cell->right->left = cell->left;
-		cell->left->right = cell->right;
+		dl::Index const index = cellIndex(row, i);
+		dl::Index const column = static_cast<dl::Index>(items[i]);
+		Node& cell = nodes[index];
 
-		// for each cell in the column
-		for (Cell* i = cell->down; i != cell; i = i->down)
-		{
-			// and for each cell in the row, remove it
-			for (Cell* j = i->right; j != i; j = j->right)
-			{
-				j->down->up = j->up;
-				j->up->down = j->down;
-				--j->col->count;
-			}
-		}
+		built.col[index] = column;
+		built.matrix.counts.increment(column);
+
+		// insert vertically
+		cell.up = nodes[column].up;
+		cell.down = column;
+
+		nodes[nodes[column].up].down = index;
+		nodes[column].up = index;
 	}
 
-	// Uncover a column
-	void uncover(Column* cell)
+	// insert horizontally
+	linkRow(built, nodes, row);
+}
+
+template <int32_t box_size, typename Rows>
+constexpr void SudokuMatrix<box_size, Rows>::linkHeader(dl::Links<dl::Index>& column, int32_t i)
+{
+	column.right = static_cast<dl::Index>((i + 1) % column_size);
+	column.left = static_cast<dl::Index>((column_size - 1 + i) % column_size);
+}
+
+template <int32_t box_size, typename Rows>
+constexpr void SudokuMatrix<box_size, Rows>::linkHeader(dl::VerticalLinks<dl::Index>&, int32_t)
+{
+}
+
+template <int32_t box_size, typename Rows>
+constexpr void SudokuMatrix<box_size, Rows>::linkRow(Prebuilt&, dl::Links<dl::Index>* nodes, int32_t row)
+{
+	for (int32_t i = 0; i < cells_per_row; ++i)
 	{
-		// for each cell in the column, from bottom up
-		for (Cell* i = cell->up; i != cell; i = i->up)
-		{
-			// and for each cell in the row, from left to right, add it back in
-			for (Cell* j = i->left; j != i; j = j->left)
-			{
-				++j->col->count;
-				j->down->up = j;
-				j->up->down = j;
-			}
-		}
+		dl::Links<dl::Index>& cell = nodes[cellIndex(row, i)];
+		cell.right = cellIndex(row, (i + 1) % cells_per_row);
+		cell.left = cellIndex(row, (cells_per_row - 1 + i) % cells_per_row);
+	}
+}
 
-		// add the column header back in
-		cell->right->left = cell;
-		cell->left->right = cell;
+template <int32_t box_size, typename Rows>
+constexpr void SudokuMatrix<box_size, Rows>::linkRow(Prebuilt& built, dl::VerticalLinks<dl::Index>* nodes, int32_t row)
+{
+	dl::Index const first = cellIndex(row, 0);
+	dl::Index const last = cellIndex(row, cells_per_row - 1);
+
+	// the spacer before the row leads on to its last cell and the one
+	// after back to its first, the one after is also before the next row
+	built.col[first - 1] = dl::spacerColumn<dl::Index>();
+	nodes[first - 1].down = last;
+	built.col[last + 1] = dl::spacerColumn<dl::Index>();
+	nodes[last + 1].up = first;
+}
+
+template <int32_t box_size, typename Rows>
+constexpr typename SudokuMatrix<box_size, Rows>::Prebuilt SudokuMatrix<box_size, Rows>::prebuilt = SudokuMatrix<box_size, Rows>::build();
+
+template <int32_t box_size, typename Stats, typename Rows>
+BasicSudoku<box_size, Stats, Rows>::BasicSudoku()
+	: matrix(Layout::prebuilt.matrix)
+{
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::reset()
+{
+	matrix = Layout::prebuilt.matrix;
+	frame_count = 0;
+	clue_count = 0;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::setEngine(SearchEngine search_engine)
+{
+	engine = search_engine;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::setPropagation(bool enabled)
+{
+	propagation = enabled;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::setCancelFlag(std::atomic<bool> const* flag,
+	std::atomic<bool> const* outer)
+{
+	cancel_flag = flag;
+	outer_cancel_flag = outer;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+std::atomic<bool> const* BasicSudoku<box_size, Stats, Rows>::cancelFlag() const
+{
+	return cancel_flag;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::setLimits(SearchLimits const& limits)
+{
+	search_limits = limits;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SearchLimits const& BasicSudoku<box_size, Stats, Rows>::limits() const
+{
+	return search_limits;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::startPolling()
+{
+	nodes_polled = 0;
+	cancelled = false;
+	timed_out = false;
+
+	if (search_limits.time != std::chrono::steady_clock::duration::zero())
+	{
+		deadline = std::chrono::steady_clock::now() + search_limits.time;
 	}
+	schedulePoll();
 }
 
-namespace
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::schedulePoll()
 {
-	Sudoku::Sudoku()
+	uint64_t length = poll_interval;
+	if (search_limits.nodes != 0)
 	{
-		// construct columns for dancing links
-		for (int32_t i = 0; i < column_size; ++i)
+		// Polling on entering the node after the last one allowed, so all
+		// of the limit is searched and nodes_polled passes it by that one
+		uint64_t const remaining = search_limits.nodes - nodes_polled;
+		if (remaining < length)
 		{
-			// columns begin as only item in the column
-			columns[i].up = &columns[i];
-			columns[i].down = &columns[i];
-
-			// set right and left values
-			columns[i].right = &columns[(i + 1) % column_size];
-			columns[i].left = &columns[(column_size - 1 + i) % column_size];
-
-			// set metadata
-			columns[i].count = 0;
-			columns[i].col = &columns[i];
-			columns[i].name = "column " + std::to_string(i);
+			length = remaining + 1;
 		}
+	}
+	poll_length = static_cast<uint32_t>(length);
+	poll_countdown = poll_length;
+}
 
-		// Traditionally Donald knuths paper uses the root on the left, here
-		// a right most column is used as a root, to conserve indexing from 0
-		root = &columns[column_size - 1];
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::poll()
+{
+	nodes_polled += poll_length;
 
-		// Construct all 729 rows, each column should have 9 items
-		for (int32_t i = 0; i < row_size; ++i)
-		{
-			int32_t const col = (i / 9) % 9;
-			int32_t const row = i / 81;
-			int32_t const num = i % 9;
+	if (search_limits.nodes != 0 && nodes_polled > search_limits.nodes)
+	{
+		timed_out = true;
+	}
+	else if (search_limits.time != std::chrono::steady_clock::duration::zero() &&
+		std::chrono::steady_clock::now() >= deadline)
+	{
+		timed_out = true;
+	}
+	else if ((cancel_flag && cancel_flag->load(std::memory_order_relaxed)) ||
+		(outer_cancel_flag && outer_cancel_flag->load(std::memory_order_relaxed)))
+	{
+		cancelled = true;
+	}
 
-			int32_t const col_block_group = col / 3;
-			int32_t const row_block_group = row / 3;
+	if (timed_out || cancelled)
+	{
+		// The node polling on entry is not searched, and the countdown is
+		// left at zero so nodeCount stays at the nodes that were
+		--nodes_polled;
+		poll_length = 0;
+		poll_countdown = 0;
+		return true;
+	}
 
-			int32_t const cell_constraint = i / 9;
-			int32_t const row_constraint = (row * 9) + num;
-			int32_t const column_constraint = i % 81;
-			int32_t const block_constraint = row_block_group * 27 + col_block_group * 9 + num;
+	schedulePoll();
+	return false;
+}
 
-			insertRow({ cell_constraint, 81 + row_constraint, 162 + column_constraint, 243 + block_constraint });
-		}
+template <int32_t box_size, typename Stats, typename Rows>
+Stats const& BasicSudoku<box_size, Stats, Rows>::stats() const
+{
+	return search_stats;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::clearStats()
+{
+	search_stats = Stats();
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+std::string BasicSudoku<box_size, Stats, Rows>::columnName(int32_t column)
+{
+	if (column == root)
+	{
+		return "root";
 	}
 
-	/**
-		Function for inserting a row into the bottom of the dancing links matrix
-	*/
-	void Sudoku::insertRow(std::array<int32_t, cells_per_row> const& items)
+	// Matches the constraint layout of the constructor, digits from 1
+	int32_t const index = column % grid_size;
+	std::string const unit = std::to_string(index / size + 1);
+	std::string const num = std::to_string(index % size + 1);
+
+	switch (column / grid_size)
 	{
-		for (int32_t i = 0; i < cells_per_row; ++i)
-		{
-			auto* const cell = &cells[row_count][i];
+	case 0:
+		return "cell r" + unit + "c" + num;
+	case 1:
+		return "row " + unit + " has " + num;
+	case 2:
+		return "col " + unit + " has " + num;
+	default:
+		return "box " + unit + " has " + num;
+	}
+}
 
-			cell->col = &columns[items[i]];
-			cell->row = row_count;
-			++cell->col->count;
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::decodeSolution(Grid& grid) const
+{
+	for (int32_t k = 0; k < grid_size; ++k)
+	{
+		int32_t const col = (solution[k] / size) % size;
+		int32_t const row = solution[k] / grid_size;
+		int32_t const num = solution[k] % size;
+		grid[row * size + col] = num + 1;
+	}
+}
 
-			// insert vertically
-			cell->up = cell->col->up;
-			cell->down = cell->col;
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::reportSolution()
+{
+	if (first_solution && solution_count == 0)
+	{
+		decodeSolution(*first_solution);
+	}
 
-			cell->col->up->down = cell;
-			cell->col->up = cell;
+	if (on_solution)
+	{
+		Grid grid;
+		decodeSolution(grid);
+		(*on_solution)(grid);
+	}
+}
 
-			// insert horizontally
-			cell->right = &cells[row_count][(i + 1) % cells_per_row];
-			cell->left = &cells[row_count][(cells_per_row - 1 + i) % cells_per_row];
-		}
-		++row_count;
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::coverColumn(dl::Index c)
+{
+	search_stats.cover(matrix.counts.count[c] * (cells_per_row - 1));
+	dl::cover(matrix.nodes, Layout::prebuilt.col, matrix.counts, c);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::uncoverColumn(dl::Index c)
+{
+	// a covered column keeps its rows, so it has as many as when covered
+	search_stats.uncover(matrix.counts.count[c] * (cells_per_row - 1));
+	dl::uncover(matrix.nodes, Layout::prebuilt.col, matrix.counts, c);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::selectRow(dl::Index cell, int32_t k)
+{
+	solution[k] = Layout::rowOf(cell);
+
+	dl::Index const* const col = Layout::prebuilt.col;
+	for (dl::Index j = Rows::next(matrix.nodes, col, cell); j != cell; j = Rows::next(matrix.nodes, col, j))
+	{
+		coverColumn(Layout::prebuilt.col[j]);
 	}
+}
 
-	void Sudoku::printSolution()
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::unselectRow(dl::Index cell)
+{
+	dl::Index const* const col = Layout::prebuilt.col;
+	for (dl::Index j = Rows::previous(matrix.nodes, col, cell); j != cell; j = Rows::previous(matrix.nodes, col, j))
 	{
-		// Decode matrix row to grid (row, col, value)
-		int32_t grid_solution[9][9];
+		uncoverColumn(Layout::prebuilt.col[j]);
+	}
+}
 
-		for (int32_t k = 0; k < grid_size; ++k)
+/**
+	Forced moves, each column left with one row has that row picked
+	without branching until a column has more or none
+*/
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::propagate(int32_t& k, dl::Index& column)
+{
+	for (;;)
+	{
+		dl::Index const c = chooseColumn();
+		if (c == root || matrix.counts.count[c] > 1)
 		{
-			int32_t const col = (solution[k] / 9) % 9;
-			int32_t const row = solution[k] / 81;
-			int32_t const num = solution[k] % 9;
-			grid_solution[row][col] = num;
+			column = c;
+			return true;
 		}
 
-		std::cout << "-----" << std::endl;
-		for (int32_t i = 0; i < 9; ++i)
+		if (matrix.counts.count[c] == 0)
 		{
-			for (int32_t j = 0; j < 9; ++j)
-			{
-				std::cout << (grid_solution[i][j] + 1) << " ";
-			}
-			std::cout << std::endl;
+			return false;
 		}
-		std::cout << "-----" << std::endl;
+
+		dl::Index const r = matrix.nodes[c].down;
+		coverColumn(c);
+		selectRow(r, k);
+		forced[k] = r;
+		++k;
 	}
+}
 
-	/**
-		Search algorithm as defined by AlgorithmX
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::unpropagate(int32_t begin, int32_t end)
+{
+	for (int32_t k = end - 1; k >= begin; --k)
+	{
+		dl::Index const r = forced[k];
+		unselectRow(r);
+		uncoverColumn(Layout::prebuilt.col[r]);
+	}
+}
+
+/**
+	Search algorithm as defined by AlgorithmX
+
+	1. pick a candidate Column, the column with the least
+		entries will limit branching.
+	2. pick a row in that column, and for each cell in that
+		row, cover it's column
+	3. repeat step 1 until no column remains and thus a solution
+		is found or until there are columns with 0 entries
+		and then the column is uncovered again and the previous
+		row decision is undone and a new row is tried
+
+*/
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::search(int32_t k)
+{
+	if (interrupted())
+	{
+		return true;
+	}
+	search_stats.node();
 
-		1. pick a candidate Column, the column with the least
-			entries will limit branching.
-		2. pick a row in that column, and for each cell in that
-			row, cover it's column
-		3. repeat step 1 until no column remains and thus a solution
-			is found or until there are columns with 0 entries
-			and then the column is uncovered again and the previous
-			row decision is undone and a new row is tried
+	int32_t const forced_begin = k;
+	dl::Index c = root;
 
-	*/
-	void Sudoku::search(int32_t k)
+	if (propagation)
 	{
-		if (root->right == root)
+		if (!propagate(k, c))
 		{
-			printSolution();
-			return;
+			unpropagate(forced_begin, k);
+			return false;
 		}
+	}
+	else
+	{
+		c = chooseColumn();
 
-		dl::Cell* c = root->right;
-		// By picking the column with the least amount of entries we can limit
-		// the amount of branching we do
-		for (dl::Cell* candidate = root->right; candidate != root; candidate = candidate->right)
+		// no row can satisfy the column, so nothing below this level can
+		// be a solution
+		if (c != root && matrix.counts.count[c] == 0)
 		{
-			if (candidate->col->count < c->col->count)
-			{
-				c = candidate;
-			}
+			return false;
 		}
+	}
 
-		cover(c->col);
+	bool stop = false;
+	if (c == root)
+	{
+		reportSolution();
+		stop = ++solution_count >= solution_limit;
+	}
+	else
+	{
+		search_stats.branch(k, matrix.counts.count[c]);
+		coverColumn(c);
 
-		for (dl::Cell* r = c->down; r != c; r = r->down)
+		for (dl::Index r = matrix.nodes[c].down; r != c && !stop; r = matrix.nodes[r].down)
 		{
-			solution[k] = r->row;
+			selectRow(r, k);
 
-			for (dl::Cell* j = r->right; j != r; j = j->right)
+			stop = search(k + 1);
+
+			unselectRow(r);
+		}
+		uncoverColumn(c);
+	}
+
+	unpropagate(forced_begin, k);
+	return stop;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::beginSearch(int32_t k)
+{
+	frame_count = 0;
+	picked = k;
+	descending = true;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::resumeSearch(uint64_t steps)
+{
+	for (;;)
+	{
+		if (descending)
+		{
+			if (steps == 0)
 			{
-				dl::cover(j->col);
+				return false;
 			}
+			--steps;
 
-			search(k + 1);
+			if (interrupted())
+			{
+				unwindSearch();
+				return true;
+			}
+			search_stats.node();
 
-			for (dl::Cell* j = r->left; j != r; j = j->left)
+			int32_t const forced_begin = picked;
+			dl::Index c = root;
+			bool alive = true;
+
+			if (propagation)
+			{
+				alive = propagate(picked, c);
+			}
+			else
 			{
-				dl::uncover(j->col);
+				c = chooseColumn();
+				alive = c == root || matrix.counts.count[c] != 0;
 			}
 
+			if (!alive || c == root)
+			{
+				// a leaf, undo what propagation picked and backtrack
+				bool stop = false;
+				if (alive)
+				{
+					reportSolution();
+					stop = ++solution_count >= solution_limit;
+				}
+
+				unpropagate(forced_begin, picked);
+				picked = forced_begin;
+
+				if (stop)
+				{
+					unwindSearch();
+					return true;
+				}
+				descending = false;
+				continue;
+			}
+
+			search_stats.branch(picked, matrix.counts.count[c]);
+			coverColumn(c);
+
+			frames[frame_count] = { c, matrix.nodes[c].down, picked, forced_begin };
+			++frame_count;
+		}
+		else
+		{
+			if (frame_count == 0)
+			{
+				return true;
+			}
+
+			// done with the subtree below the current row, move to the next
+			Frame& frame = frames[frame_count - 1];
+			unselectRow(frame.row);
+			frame.row = matrix.nodes[frame.row].down;
+		}
+
+		Frame const& frame = frames[frame_count - 1];
+		if (frame.row == frame.column)
+		{
+			// every row of the column has been tried, backtrack
+			uncoverColumn(frame.column);
+			unpropagate(frame.forced, frame.k);
+			picked = frame.forced;
+			--frame_count;
+			descending = false;
+		}
+		else
+		{
+			selectRow(frame.row, frame.k);
+			picked = frame.k + 1;
+			descending = true;
+		}
+	}
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::unwindSearch()
+{
+	// every frame on the stack has its current row picked
+	for (; frame_count > 0; --frame_count)
+	{
+		Frame const& frame = frames[frame_count - 1];
+		unselectRow(frame.row);
+		uncoverColumn(frame.column);
+		unpropagate(frame.forced, frame.k);
+		picked = frame.forced;
+	}
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::loadGridAndSolve(Grid const& grid, Grid* solution,
+	SearchMode mode, uint64_t limit)
+{
+	first_solution = solution;
+	on_solution = nullptr;
+	return solve(grid, mode, limit);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::loadGridAndSolve(Grid const& grid, SolutionCallback const& callback,
+	SearchMode mode, uint64_t limit)
+{
+	first_solution = nullptr;
+	on_solution = callback ? &callback : nullptr;
+	return solve(grid, mode, limit);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::solve(Grid const& grid, SearchMode mode, uint64_t limit)
+{
+	solution_limit = solutionLimit(mode, limit);
+	solution_count = 0;
+
+	search_stats.beginLoad();
+
+	int32_t z = 0;
+	bool const consistent = loadGrid(grid, z);
+
+	search_stats.beginSearch();
+	SolveResult const result = searchFrom(z, consistent);
+	search_stats.endSearch();
+
+	unloadGrid(z);
+	search_stats.endLoad();
+	return result;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::searchFrom(int32_t k, bool consistent)
+{
+	bool const searched = consistent && solution_limit > 0;
+	if (searched)
+	{
+		startPolling();
+		if (engine == SearchEngine::Recursive)
+		{
+			search(k);
+		}
+		else
+		{
+			beginSearch(k);
+			resumeSearch();
+		}
+	}
+	return searchResult(consistent, searched);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::searchResult(bool consistent, bool searched) const
+{
+	SolveResult result;
+	result.solutions = solution_count;
+	result.invalid = !consistent;
+	result.cancelled = searched && cancelled;
+	result.timeout = searched && timed_out;
+	result.nodes = searched ? nodeCount() : 0;
+	return result;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::startSolve(Grid const& grid, Grid* solution,
+	SearchMode mode, uint64_t limit)
+{
+	first_solution = solution;
+	on_solution = nullptr;
+	solution_limit = solutionLimit(mode, limit);
+	solution_count = 0;
+
+	search_stats.beginLoad();
+	started_clues = 0;
+	started_consistent = loadGrid(grid, started_clues);
+	started_search = started_consistent && solution_limit > 0;
+
+	search_stats.beginSearch();
+	if (started_search)
+	{
+		startPolling();
+		beginSearch(started_clues);
+	}
+	return started_search;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::advance(uint64_t steps)
+{
+	return resumeSearch(steps);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::finishSolve()
+{
+	search_stats.endSearch();
+	unloadGrid(started_clues);
+	search_stats.endLoad();
+	return searchResult(started_consistent, started_search);
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::pushClue(int32_t cell, int32_t value)
+{
+	if (cell < 0 || cell >= grid_size || value < 1 || value > size || !coverClue(cell * size + value - 1))
+	{
+		return false;
+	}
+
+	solution[clue_count] = cell * size + value - 1;
+	++clue_count;
+	return true;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::popClue()
+{
+	if (clue_count > 0)
+	{
+		--clue_count;
+		uncoverClue(solution[clue_count]);
+	}
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+int32_t BasicSudoku<box_size, Stats, Rows>::clueCount() const
+{
+	return clue_count;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+SolveResult BasicSudoku<box_size, Stats, Rows>::solveClues(Grid* solution, SearchMode mode, uint64_t limit)
+{
+	first_solution = solution;
+	on_solution = nullptr;
+	solution_limit = solutionLimit(mode, limit);
+	solution_count = 0;
+
+	search_stats.beginLoad();
+	search_stats.beginSearch();
+	SolveResult const result = searchFrom(clue_count, true);
+	search_stats.endSearch();
+	search_stats.endLoad();
+	return result;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::branch(Grid const& grid, std::vector<Grid>& children)
+{
+	int32_t z = 0;
+	bool const consistent = loadGrid(grid, z);
+
+	if (consistent)
+	{
+		dl::Index const c = chooseColumn();
+		if (c == root)
+		{
+			children.push_back(grid);
+		}
+		else
+		{
+			for (dl::Index r = matrix.nodes[c].down; r != c; r = matrix.nodes[r].down)
+			{
+				int32_t const row = Layout::rowOf(r);
+				children.push_back(grid);
+				children.back()[row / size] = row % size + 1;
+			}
 		}
-		dl::uncover(c->col);
 	}
 
-	/**
-		Simulate the state of the dancing links matrix asif the algorithm had
-		picked the rows corresponding to the current layout of the sudoku
-	*/
-	void Sudoku::loadGridAndSolve(std::vector<std::vector<int32_t>> const& grid)
+	unloadGrid(z);
+	return consistent;
+}
+
+/**
+	Simulate the state of the dancing links matrix asif the algorithm had
+	picked the rows corresponding to the current layout of the sudoku
+*/
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::loadGrid(Grid const& grid, int32_t& clues)
+{
+	// Writing from solution[0] would overwrite the rows of pushed clues
+	if (clue_count != 0)
 	{
-		int32_t z = 0;
+		clues = 0;
+		return false;
+	}
 
-		for (int32_t i = 0; i < 9; ++i)
+	int32_t z = 0;
+	bool consistent = true;
+
+	for (int32_t i = 0; i < size && consistent; ++i)
+	{
+		for (int32_t j = 0; j < size && consistent; ++j)
 		{
-			for (int32_t j = 0; j < 9; ++j)
+			int32_t const value = grid[i * size + j];
+
+			if (value < 0 || value > size)
 			{
-				if (grid[i][j] != 0)
-				{
-					// find which row this corresponds to
-					int32_t const grid_row = (81 * i) + (9 * j) + grid[i][j] - 1;
+				consistent = false;
+			}
+			else if (value != 0)
+			{
+				// find which row this corresponds to
+				int32_t const grid_row = (grid_size * i) + (size * j) + value - 1;
 
-					for (int32_t k = 0; k < cells_per_row; ++k)
-					{
-						dl::cover(cells[grid_row][k].col);
-					}
+				consistent = coverClue(grid_row);
+				if (consistent)
+				{
 					solution[z] = grid_row;
 					++z;
 				}
 			}
 		}
+	}
+
+	clues = z;
+	return consistent;
+}
 
-		search(z);
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::unloadGrid(int32_t clues)
+{
+	for (int32_t z = clues - 1; z >= 0; --z)
+	{
+		uncoverClue(solution[z]);
 	}
 }
+
+template <int32_t box_size, typename Stats, typename Rows>
+bool BasicSudoku<box_size, Stats, Rows>::coverClue(int32_t grid_row)
+{
+	// A column already covered means an earlier clue satisfies the same
+	// constraint, covering it a second time would corrupt the matrix
+	for (int32_t k = 0; k < cells_per_row; ++k)
+	{
+		dl::Index const column = Layout::prebuilt.col[Layout::cellIndex(grid_row, k)];
+		if (!matrix.counts.contains(column))
+		{
+			return false;
+		}
+	}
+
+	for (int32_t k = 0; k < cells_per_row; ++k)
+	{
+		coverColumn(Layout::prebuilt.col[Layout::cellIndex(grid_row, k)]);
+	}
+	return true;
+}
+
+template <int32_t box_size, typename Stats, typename Rows>
+void BasicSudoku<box_size, Stats, Rows>::uncoverClue(int32_t grid_row)
+{
+	for (int32_t k = cells_per_row - 1; k >= 0; --k)
+	{
+		uncoverColumn(Layout::prebuilt.col[Layout::cellIndex(grid_row, k)]);
+	}
+}
+
+template struct SudokuMatrix<3>;
+template struct SudokuMatrix<4>;
+template struct SudokuMatrix<5>;
+template struct SudokuMatrix<3, dl::SpacedRows>;
+template struct SudokuMatrix<4, dl::SpacedRows>;
+
+template class BasicSudoku<3>;
+template class BasicSudoku<4>;
+template class BasicSudoku<5>;
+template class BasicSudoku<3, SearchStats<3>>;
+template class BasicSudoku<4, SearchStats<4>>;
+template class BasicSudoku<5, SearchStats<5>>;
+template class BasicSudoku<3, NoStats, dl::SpacedRows>;
+template class BasicSudoku<4, NoStats, dl::SpacedRows>;
@@ -1,87 +1,504 @@
 ﻿#ifndef SUDOKU_H
 #define SUDOKU_H
-#include <vector>
+#include "DancingLinks.h"
+#include "SearchStats.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <type_traits>
+#include <vector>
 
-// Functions relating to the dancing links component of algorithmX
-namespace dl
+/**
+	The exact cover matrix of an empty grid of box_size x box_size boxes,
+	shared by the solvers of that size whatever their stats policy. Rows
+	is dl::CircularRows or dl::SpacedRows, how the cells of a row are
+	linked
+*/
+template <int32_t box_size, typename Rows = dl::CircularRows>
+struct SudokuMatrix
 {
-	struct Column;
+	using Node = typename Rows::template Node<dl::Index>;
+
+	// Cells along a side of the grid, and the digits each cell can take
+	static int32_t constexpr size = box_size * box_size;
+	static int32_t constexpr grid_size = size * size;
+
+	// Constraints here are grid_size * 4, for a 9x9 grid
+	// first 81 refer to each 9x9 cell being occupied
+	// second 81 refer to rowX having each 1-9
+	// third 81 refer to colX having each 1-9
+	// fourth 81 refer to each subgrid each 1-9
+	static int32_t constexpr constraints = grid_size * 4;
+
+	// 81 cells in a 9x9 sudoku, 9 choices for each
+	static int32_t constexpr row_size = grid_size * size;
+
+	// Each row always and only satifies four columns
+	static int32_t constexpr cells_per_row = 4;
+
+	// Keep a meta column header with extra spot for a root node
+	static int32_t constexpr column_size = constraints + 1;
+
+	// Column headers come first in nodes, followed by the cells of each
+	// row after a spacer when Rows has them, so the row of a cell can be
+	// calculated from its index
+	static int32_t constexpr row_stride = cells_per_row + Rows::spacers;
+	static int32_t constexpr node_count = column_size + Rows::spacers + row_size * row_stride;
+
+	// Traditionally Donald knuths paper uses the root on the left, here
+	// a right most column is used as a root, to conserve indexing from 0
+	static dl::Index constexpr root = column_size - 1;
+
+	static_assert(node_count <= UINT16_MAX, "node indices must fit in dl::Index");
 
-	struct Cell
+	/**
+		The parts of the matrix search modifies, kept together so the state
+		of a solver is copied as one block of plain data
+	*/
+	struct Matrix
 	{
-		Cell* up;
-		Cell* down;
-		Cell* left;
-		Cell* right;
-		Column* col;
-		int32_t row; //todo remove and calculate based on index
+		Node nodes[node_count];
+		// the root is not a constraint and never enters the count buckets
+		dl::Counts<column_size, size> counts;
 	};
 
-	struct Column : public Cell
+	/**
+		The matrix of an empty grid and the column of every node, which never
+		changes once built. It is generated at compile time into read only
+		data, a new solver copies it rather than inserting all row_size rows
+	*/
+	struct Prebuilt
 	{
-		int32_t count;
-		std::string name;
-
-		Column() : count(0) {}
+		Matrix matrix;
+		dl::Index col[node_count];
 	};
 
-	void cover(Column* cell);
-	void uncover(Column* cell);
-}
-namespace
+	static Prebuilt const prebuilt;
+
+	static constexpr Prebuilt build();
+
+	/**
+		Function for inserting a row into the bottom of the dancing links matrix
+	*/
+	static constexpr void insertRow(Prebuilt& built, int32_t row, std::array<int32_t, cells_per_row> const& items);
+
+	/**
+		Link header i into the ring of headers, which only the circular
+		layout has
+	*/
+	static constexpr void linkHeader(dl::Links<dl::Index>& column, int32_t i);
+	static constexpr void linkHeader(dl::VerticalLinks<dl::Index>& column, int32_t i);
+
+	/**
+		Link the cells of row to each other, around a ring or between the
+		spacers either side
+	*/
+	static constexpr void linkRow(Prebuilt& built, dl::Links<dl::Index>* nodes, int32_t row);
+	static constexpr void linkRow(Prebuilt& built, dl::VerticalLinks<dl::Index>* nodes, int32_t row);
+
+	static constexpr dl::Index cellIndex(int32_t row, int32_t i)
+	{
+		return static_cast<dl::Index>(column_size + Rows::spacers + row * row_stride + i);
+	}
+
+	static constexpr int32_t rowOf(dl::Index cell)
+	{
+		return (cell - column_size - Rows::spacers) / row_stride;
+	}
+};
+
+/**
+	A solver for sudokus made of box_size x box_size boxes, so a grid of
+	size x size cells, 3 being the classic 9x9. All storage is sized at
+	compile time, a 25x25 solver holds around 600KB of matrix so is best
+	allocated on the heap rather than the stack.
+
+	Stats is NoStats, or SearchStats<box_size> to have every search
+	instrumented. Rows picks the layout of the matrix as for SudokuMatrix,
+	the search is the same with either
+*/
+template <int32_t box_size, typename Stats = NoStats, typename Rows = dl::CircularRows>
+class BasicSudoku
 {
-	class Sudoku
+	using Layout = SudokuMatrix<box_size, Rows>;
+	using Matrix = typename Layout::Matrix;
+
+	static int32_t constexpr cells_per_row = Layout::cells_per_row;
+	static int32_t constexpr column_size = Layout::column_size;
+	static dl::Index constexpr root = Layout::root;
+
+	// Levels of the search entered between checks of the cancel flag and
+	// limits
+	static uint32_t constexpr poll_interval = 1024;
+
+public:
+	static int32_t constexpr size = Layout::size;
+	static int32_t constexpr grid_size = Layout::grid_size;
+
+	// Cells of a sudoku in row major order, 0 for an empty cell
+	using Grid = std::array<int32_t, grid_size>;
+
+	// Receives each solution as it is found
+	using SolutionCallback = std::function<void(Grid const&)>;
+
+private:
+	/**
+		A level of the iterative search, the column chosen and the row of it
+		currently picked at index k of solution. Rows forced by propagation
+		on entering the level sit at [forced, k) of solution
+	*/
+	struct Frame
 	{
-		// Constraints here are 81 * 4,
-		// first 81 refer to each 9x9 cell being occupied
-		// second 81 refer to rowX having each 1-9
-		// third 81 refer to colX having each 1-9
-		// fourth 81 refer to each subgrid each 1-9
-		static int32_t constexpr grid_size = 81;
-		static int32_t constexpr constraints = grid_size * 4;
-
-		// 81 cells in the sudoku, 9 choices for each
-		static int32_t constexpr row_size = 729;
-
-		// Each row always and only satifies four columns
-		static int32_t constexpr cells_per_row = 4;
-
-		// Keep a meta column header with extra spot for a root node
-		static int32_t constexpr column_size = constraints + 1;
-
-		int32_t row_count = 0;
-		dl::Column columns[column_size];
-		dl::Cell cells[row_size][cells_per_row];
-		dl::Column* root;
-		int32_t solution[grid_size];
-
-	public:
-		Sudoku();
-
-		/**
-			Function for inserting a row into the bottom of the dancing links matrix
-		*/
-		void insertRow(std::array<int32_t, cells_per_row> const& items);
-		void loadGridAndSolve(std::vector<std::vector<int32_t>> const& grid);
-	private:
-
-		void printSolution();
-
-		/**
-			Search algorithm as defined by AlgorithmX
-
-			1. pick a candidate Column, the column with the least
-				entries will limit branching.
-			2. pick a row in that column, and for each cell in that
-				row, cover it's column
-			3. repeat step 1 until no column remains and thus a solution
-				is found or until there are columns with 0 entries
-				and then the column is uncovered again and the previous
-				row decision is undone and a new row is tried
-
-		*/
-		void search(int32_t k = 0);
+		dl::Index column;
+		dl::Index row;
+		int32_t k;
+		int32_t forced;
 	};
-}
+
+	Matrix matrix;
+	int32_t solution[grid_size];
+
+	// The cell of each row picked by propagation, by its index in solution
+	dl::Index forced[grid_size];
+
+	SearchEngine engine = SearchEngine::Recursive;
+	bool propagation = false;
+
+	// Every row is picked at most once per cell, so the search never
+	// nests deeper than grid_size
+	Frame frames[grid_size];
+	int32_t frame_count = 0;
+	// index into solution the next row picked goes
+	int32_t picked = 0;
+	// whether the next step enters a new level or moves on to the next row
+	bool descending = false;
+
+	uint64_t solution_count = 0;
+	uint64_t solution_limit = 0;
+
+	// Rows covered by pushClue, kept at the start of solution
+	int32_t clue_count = 0;
+
+	// The clues startSolve covered, and whether it started a search
+	int32_t started_clues = 0;
+	bool started_consistent = false;
+	bool started_search = false;
+
+	// Set by another thread to stop the search, polled every poll_interval
+	// levels so reading it costs nothing measurable
+	std::atomic<bool> const* cancel_flag = nullptr;
+	std::atomic<bool> const* outer_cancel_flag = nullptr;
+	SearchLimits search_limits;
+
+	// The levels entered up to the last poll, and the levels until the
+	// next out of poll_length
+	uint64_t nodes_polled = 0;
+	uint32_t poll_length = poll_interval;
+	uint32_t poll_countdown = poll_interval;
+	std::chrono::steady_clock::time_point deadline;
+	bool cancelled = false;
+	bool timed_out = false;
+
+	// Destinations for solutions found by the current search
+	Grid* first_solution = nullptr;
+	SolutionCallback const* on_solution = nullptr;
+
+	Stats search_stats;
+
+public:
+	BasicSudoku();
+
+	/**
+		Restore the matrix to its constructed state by copying the prebuilt
+		matrix over it, whatever clues or rows are currently covered,
+		pushed clues included
+	*/
+	void reset();
+
+	/**
+		Pick the search implementation used by later calls
+	*/
+	void setEngine(SearchEngine search_engine);
+
+	/**
+		When enabled, on entering each level of the search any column left
+		with a single row has that row picked without branching, until no
+		such column remains. Naked and hidden singles are columns of this
+		kind, so puzzles solved by singles alone are solved without search
+	*/
+	void setPropagation(bool enabled);
+
+	/**
+		Have later searches poll flag, stopping soon after it is set with
+		the matrix restored and the result marked cancelled. nullptr, the
+		default, stops polling. outer is polled as well, so a search that
+		cancels its own copies of a solver still stops on the flag the
+		caller gave
+	*/
+	void setCancelFlag(std::atomic<bool> const* flag, std::atomic<bool> const* outer = nullptr);
+	std::atomic<bool> const* cancelFlag() const;
+
+	/**
+		Bound the nodes and time of later searches, each search counting
+		from the start of its loadGridAndSolve. One that runs out unwinds
+		and returns the solutions found so far with the result marked
+		timeout, leaving the solver ready for the next puzzle
+	*/
+	void setLimits(SearchLimits const& limits);
+	SearchLimits const& limits() const;
+
+	/**
+		Describe the constraint a column represents, built on demand as it is
+		only needed for debug output
+	*/
+	static std::string columnName(int32_t column);
+
+	/**
+		Cover the clues of the grid and search for solutions. The matrix is
+		restored to its constructed state before returning, so the same
+		instance can be reused for any number of puzzles
+
+		limit is only used by SearchMode::CountUpTo. The first solution
+		found is written to solution when it is not null. While a clue is
+		pushed nothing is searched and the result is invalid, as for branch
+	*/
+	SolveResult loadGridAndSolve(Grid const& grid, Grid* solution,
+		SearchMode mode = SearchMode::FirstSolution, uint64_t limit = 0);
+
+	/**
+		As above but on_solution is called with every solution found
+	*/
+	SolveResult loadGridAndSolve(Grid const& grid, SolutionCallback const& on_solution,
+		SearchMode mode = SearchMode::CountAll, uint64_t limit = 0);
+
+	/**
+		Split grid on the column search would branch on first, appending to
+		children a copy of grid for each row of that column with the cell of
+		the row filled in. Together the children have exactly the solutions
+		of grid, so they can be searched independently. A grid with every
+		cell filled is appended as it is and one left with an unsatisfiable
+		constraint appends nothing. Returns false, appending nothing, when
+		the clues are invalid
+	*/
+	bool branch(Grid const& grid, std::vector<Grid>& children);
+
+	/**
+		loadGridAndSolve in three parts, so a caller can search several
+		puzzles in turn on one thread. startSolve covers the clues of grid
+		and readies the iterative search, returning false when there is
+		nothing to search. advance then runs at most steps levels of it,
+		returning true once it is over, and finishSolve uncovers the clues
+		and returns the result. Nothing else may use the solver in between
+	*/
+	bool startSolve(Grid const& grid, Grid* solution,
+		SearchMode mode = SearchMode::FirstSolution, uint64_t limit = 0);
+	bool advance(uint64_t steps);
+	SolveResult finishSolve();
+
+	/**
+		Cover the row of value in cell, leaving it covered across searches
+		so a puzzle can be changed a clue at a time. Returns false, covering
+		nothing, when value is out of range or conflicts with a clue already
+		pushed
+	*/
+	bool pushClue(int32_t cell, int32_t value);
+
+	/**
+		Uncover the clue pushed last. Dancing links uncover in the reverse
+		order of covering, so only the latest clue can be taken back
+	*/
+	void popClue();
+	int32_t clueCount() const;
+
+	/**
+		Search the puzzle of the pushed clues as loadGridAndSolve does, the
+		clues stay covered afterwards
+	*/
+	SolveResult solveClues(Grid* solution, SearchMode mode = SearchMode::FirstSolution,
+		uint64_t limit = 0);
+
+	/**
+		The totals of every search since construction or clearStats
+	*/
+	Stats const& stats() const;
+	void clearStats();
+private:
+	SolveResult solve(Grid const& grid, SearchMode mode, uint64_t limit);
+
+	/**
+		Search with the next row picked at index k of solution, or only
+		report consistent as invalid when it is false
+	*/
+	SolveResult searchFrom(int32_t k, bool consistent);
+
+	/**
+		The result of the search just finished
+	*/
+	SolveResult searchResult(bool consistent, bool searched) const;
+
+	/**
+		Cover the columns of grid_row as a clue, returning false, covering
+		nothing, when one of them is already covered by an earlier clue
+	*/
+	bool coverClue(int32_t grid_row);
+	void uncoverClue(int32_t grid_row);
+
+	/**
+		Cover the rows of the clues of grid, recording them at the start of
+		solution. Sets clues to the number covered, which unloadGrid takes
+		even when false is returned for an invalid grid. Returns false,
+		covering nothing, while a clue is pushed
+	*/
+	bool loadGrid(Grid const& grid, int32_t& clues);
+
+	/**
+		Uncover the first clues rows of solution in reverse order of
+		loadGridAndSolve covering them
+	*/
+	void unloadGrid(int32_t clues);
+
+	/**
+		dl::cover and uncover on the matrix, telling stats of them
+	*/
+	void coverColumn(dl::Index c);
+	void uncoverColumn(dl::Index c);
+
+	/**
+		Decode the rows picked in solution to the grid (row, col, value)
+	*/
+	void decodeSolution(Grid& grid) const;
+
+	void reportSolution();
+
+	/**
+		Cover the columns of the row of cell, other than the column of cell
+		which the caller covers, and record the row as picked at index k
+	*/
+	void selectRow(dl::Index cell, int32_t k);
+	void unselectRow(dl::Index cell);
+
+	/**
+		The uncovered column with the fewest rows left, root when every
+		column is covered
+	*/
+	dl::Index chooseColumn() const
+	{
+		return matrix.counts.minimum(root);
+	}
+
+	/**
+		Pick the row of every column with a single row left, recording them
+		from index k of solution and advancing k past them. Returns false on
+		reaching a column with no rows, otherwise column is set to the
+		column to branch on, or root when every column is covered
+	*/
+	bool propagate(int32_t& k, dl::Index& column);
+
+	/**
+		Undo the rows propagate picked at [begin, end) of solution
+	*/
+	void unpropagate(int32_t begin, int32_t end);
+
+	/**
+		Search algorithm as defined by AlgorithmX
+
+		1. pick a candidate Column, the column with the least
+			entries will limit branching.
+		2. pick a row in that column, and for each cell in that
+			row, cover it's column
+		3. repeat step 1 until no column remains and thus a solution
+			is found or until there are columns with 0 entries
+			and then the column is uncovered again and the previous
+			row decision is undone and a new row is tried
+
+		Returns true once solution_limit is reached or the search is
+		cancelled, every level still uncovers what it covered on the way out
+	*/
+	bool search(int32_t k = 0);
+
+	/**
+		The same search driven by frames instead of the call stack
+
+		beginSearch sets up an empty stack with the next row picked at index
+		k, resumeSearch then runs until the tree is exhausted or
+		solution_limit is reached, returning true, or until it has entered
+		steps levels, returning false with the search paused where it can
+		be resumed. Once over no frame is left on the stack and the matrix
+		is as it was when the search began
+	*/
+	void beginSearch(int32_t k);
+	bool resumeSearch(uint64_t steps = UINT64_MAX);
+
+	/**
+		Pop every frame, uncovering in reverse order
+	*/
+	void unwindSearch();
+
+	/**
+		Count a level of the search entered, returning whether the search
+		must stop. The cancel flag and limits are only checked by poll every
+		poll_length calls, search unwinds as it does once solution_limit is
+		reached
+	*/
+	bool interrupted()
+	{
+		if (--poll_countdown != 0)
+		{
+			return false;
+		}
+		return poll();
+	}
+
+	bool poll();
+
+	/**
+		Start counting nodes and the time for a new search
+	*/
+	void startPolling();
+
+	/**
+		Set the levels until the next poll, fewer than poll_interval when
+		the node limit is closer
+	*/
+	void schedulePoll();
+
+	uint64_t nodeCount() const
+	{
+		return nodes_polled + (poll_length - poll_countdown);
+	}
+};
+
+// The sizes instantiated in Sudoku.cpp, each with and without stats
+using Sudoku = BasicSudoku<3>;
+using Sudoku16 = BasicSudoku<4>;
+using Sudoku25 = BasicSudoku<5>;
+
+using InstrumentedSudoku = BasicSudoku<3, SearchStats<3>>;
+using InstrumentedSudoku16 = BasicSudoku<4, SearchStats<4>>;
+using InstrumentedSudoku25 = BasicSudoku<5, SearchStats<5>>;
+
+// The DLX2 layout, 25x25 has too many nodes with spacers for dl::Index
+using SpacedSudoku = BasicSudoku<3, NoStats, dl::SpacedRows>;
+using SpacedSudoku16 = BasicSudoku<4, NoStats, dl::SpacedRows>;
+
+extern template struct SudokuMatrix<3>;
+extern template struct SudokuMatrix<4>;
+extern template struct SudokuMatrix<5>;
+extern template struct SudokuMatrix<3, dl::SpacedRows>;
+extern template struct SudokuMatrix<4, dl::SpacedRows>;
+
+extern template class BasicSudoku<3>;
+extern template class BasicSudoku<4>;
+extern template class BasicSudoku<5>;
+extern template class BasicSudoku<3, SearchStats<3>>;
+extern template class BasicSudoku<4, SearchStats<4>>;
+extern template class BasicSudoku<5, SearchStats<5>>;
+extern template class BasicSudoku<3, NoStats, dl::SpacedRows>;
+extern template class BasicSudoku<4, NoStats, dl::SpacedRows>;
+
+// Solvers hold no heap allocations, so they can be pooled or copied as plain memory
+static_assert(std::is_trivially_copyable<Sudoku>::value, "Sudoku must stay trivially copyable");
 #endif // SUDOKU_H
\ No newline at end of file
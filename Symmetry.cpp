@@ -0,0 +1,271 @@
+﻿#include "Symmetry.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	int32_t constexpr box_size = 3;
+	int32_t constexpr size = Sudoku::size;
+
+	using Order = std::array<int32_t, box_size>;
+	using BandKey = std::array<int32_t, box_size>;
+
+	Order constexpr orders[] = {
+		{ { 0, 1, 2 } }, { { 0, 2, 1 } }, { { 1, 0, 2 } },
+		{ { 1, 2, 0 } }, { { 2, 0, 1 } }, { { 2, 1, 0 } },
+	};
+
+	/**
+		The orders of three items putting their keys in descending order,
+		several when keys tie
+	*/
+	template <typename Key>
+	std::vector<Order> descending(Key const (&keys)[box_size])
+	{
+		std::vector<Order> result;
+		for (Order const& order : orders)
+		{
+			if (!(keys[order[0]] < keys[order[1]]) && !(keys[order[1]] < keys[order[2]]))
+			{
+				result.push_back(order);
+			}
+		}
+		return result;
+	}
+
+	/**
+		The orders left to try for the bands of a grid, the rows of each
+		band, its stacks and the columns of each stack
+	*/
+	struct Choices
+	{
+		std::vector<Order> lists[2 * (box_size + 1)];
+
+		/**
+			Drop ties from the longest lists until at most budget
+			combinations remain
+		*/
+		void limit(size_t budget)
+		{
+			for (;;)
+			{
+				size_t combinations = 1;
+				std::vector<Order>* longest = &lists[0];
+				for (std::vector<Order>& list : lists)
+				{
+					combinations *= list.size();
+					if (list.size() > longest->size())
+					{
+						longest = &list;
+					}
+				}
+				if (combinations <= budget)
+				{
+					return;
+				}
+				longest->resize(1);
+			}
+		}
+	};
+
+	/**
+		Order lines, rows or columns, by the number of clues they hold and
+		then by how many clues the lines crossing those clues hold, neither
+		of which any transform changes. Lines ordered within each band give
+		list index 1 on, the bands by the keys of their lines list 0
+	*/
+	void orderLines(int32_t const (&keys)[size], std::vector<Order>* lists)
+	{
+		BandKey band_keys[box_size];
+		for (int32_t b = 0; b < box_size; ++b)
+		{
+			int32_t line_keys[box_size];
+			for (int32_t i = 0; i < box_size; ++i)
+			{
+				line_keys[i] = keys[b * box_size + i];
+				band_keys[b][i] = line_keys[i];
+			}
+			std::sort(band_keys[b].rbegin(), band_keys[b].rend());
+			lists[1 + b] = descending(line_keys);
+		}
+		lists[0] = descending(band_keys);
+	}
+
+	/**
+		The permutation of lines given by the orders chosen of lists
+	*/
+	std::array<int32_t, size> lineOrder(std::vector<Order> const* lists, size_t const* choice)
+	{
+		std::array<int32_t, size> lines;
+		Order const& bands = lists[0][choice[0]];
+		for (int32_t b = 0; b < box_size; ++b)
+		{
+			Order const& inner = lists[1 + bands[b]][choice[1 + bands[b]]];
+			for (int32_t i = 0; i < box_size; ++i)
+			{
+				lines[b * box_size + i] = bands[b] * box_size + inner[i];
+			}
+		}
+		return lines;
+	}
+}
+
+namespace symmetry
+{
+	Sudoku::Grid apply(Transform const& transform, Sudoku::Grid const& grid)
+	{
+		Sudoku::Grid out;
+		for (int32_t r = 0; r < size; ++r)
+		{
+			for (int32_t c = 0; c < size; ++c)
+			{
+				int32_t const from = transform.transpose
+					? transform.cols[c] * size + transform.rows[r]
+					: transform.rows[r] * size + transform.cols[c];
+				out[r * size + c] = transform.digits[grid[from]];
+			}
+		}
+		return out;
+	}
+
+	Sudoku::Grid invert(Transform const& transform, Sudoku::Grid const& transformed)
+	{
+		std::array<int32_t, size + 1> digits;
+		for (int32_t d = 0; d <= size; ++d)
+		{
+			digits[transform.digits[d]] = d;
+		}
+
+		Sudoku::Grid out;
+		for (int32_t r = 0; r < size; ++r)
+		{
+			for (int32_t c = 0; c < size; ++c)
+			{
+				int32_t const to = transform.transpose
+					? transform.cols[c] * size + transform.rows[r]
+					: transform.rows[r] * size + transform.cols[c];
+				out[to] = digits[transformed[r * size + c]];
+			}
+		}
+		return out;
+	}
+
+	Transform canonicalize(Sudoku::Grid const& grid, Sudoku::Grid& canonical)
+	{
+		Transform best;
+		bool found = false;
+
+		for (int32_t transpose = 0; transpose < 2; ++transpose)
+		{
+			Sudoku::Grid oriented;
+			for (int32_t r = 0; r < size; ++r)
+			{
+				for (int32_t c = 0; c < size; ++c)
+				{
+					oriented[r * size + c] = transpose ? grid[c * size + r] : grid[r * size + c];
+				}
+			}
+
+			int32_t row_clues[size] = {};
+			int32_t col_clues[size] = {};
+			for (int32_t i = 0; i < Sudoku::grid_size; ++i)
+			{
+				if (oriented[i] != 0)
+				{
+					++row_clues[i / size];
+					++col_clues[i % size];
+				}
+			}
+
+			// Crossing counts stay below size * size, so clue counts lead
+			int32_t row_keys[size];
+			int32_t col_keys[size];
+			for (int32_t i = 0; i < size; ++i)
+			{
+				row_keys[i] = row_clues[i] * Sudoku::grid_size;
+				col_keys[i] = col_clues[i] * Sudoku::grid_size;
+			}
+			for (int32_t i = 0; i < Sudoku::grid_size; ++i)
+			{
+				if (oriented[i] != 0)
+				{
+					row_keys[i / size] += col_clues[i % size];
+					col_keys[i % size] += row_clues[i / size];
+				}
+			}
+
+			Choices choices;
+			orderLines(row_keys, choices.lists);
+			orderLines(col_keys, choices.lists + box_size + 1);
+			choices.limit(max_candidates);
+
+			// Every combination of the orders left, counted in mixed radix
+			size_t choice[2 * (box_size + 1)] = {};
+			size_t constexpr col_lists = box_size + 1;
+			for (bool more = true; more;)
+			{
+				std::array<int32_t, size> const rows = lineOrder(choices.lists, choice);
+				std::array<int32_t, size> const cols = lineOrder(choices.lists + col_lists, choice + col_lists);
+
+				// Relabel digits in order of first appearance, giving up as
+				// soon as the candidate is known to be greater than the best
+				std::array<int32_t, size + 1> labels = {};
+				int32_t next = 1;
+				bool less = !found;
+				bool greater = false;
+				Sudoku::Grid candidate;
+				for (int32_t i = 0; i < Sudoku::grid_size && !greater; ++i)
+				{
+					int32_t value = oriented[rows[i / size] * size + cols[i % size]];
+					if (value != 0)
+					{
+						if (labels[value] == 0)
+						{
+							labels[value] = next++;
+						}
+						value = labels[value];
+					}
+
+					if (!less)
+					{
+						less = value < canonical[i];
+						greater = value > canonical[i];
+					}
+					candidate[i] = value;
+				}
+
+				if (less)
+				{
+					// digits without a clue take the labels left, in order
+					for (int32_t d = 1; d <= size; ++d)
+					{
+						if (labels[d] == 0)
+						{
+							labels[d] = next++;
+						}
+					}
+
+					canonical = candidate;
+					best.transpose = transpose != 0;
+					best.rows = rows;
+					best.cols = cols;
+					best.digits = labels;
+					found = true;
+				}
+
+				more = false;
+				for (size_t l = 0; l < 2 * col_lists && !more; ++l)
+				{
+					more = ++choice[l] < choices.lists[l].size();
+					if (!more)
+					{
+						choice[l] = 0;
+					}
+				}
+			}
+		}
+
+		return best;
+	}
+}
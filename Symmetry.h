@@ -0,0 +1,51 @@
+﻿#ifndef SYMMETRY_H
+#define SYMMETRY_H
+#include "Sudoku.h"
+
+#include <array>
+#include <cstdint>
+
+// The transformations of a 9x9 grid that keep it a sudoku, and puzzles
+// brought to a canonical form under them
+namespace symmetry
+{
+	/**
+		Cell (r, c) of the transformed grid is cell (rows[r], cols[c]) of
+		the original, or (cols[c], rows[r]) when transposed, its digit d
+		relabelled digits[d]. rows and cols only permute rows within bands
+		and the bands themselves, likewise for columns, so every transform
+		maps solutions to solutions
+	*/
+	struct Transform
+	{
+		bool transpose = false;
+		std::array<int32_t, Sudoku::size> rows;
+		std::array<int32_t, Sudoku::size> cols;
+		// digits[0] is 0, an empty cell stays empty
+		std::array<int32_t, Sudoku::size + 1> digits;
+	};
+
+	Sudoku::Grid apply(Transform const& transform, Sudoku::Grid const& grid);
+
+	/**
+		The grid that apply takes to transformed
+	*/
+	Sudoku::Grid invert(Transform const& transform, Sudoku::Grid const& transformed);
+
+	/**
+		Write to canonical the least grid, comparing cells in row major
+		order, of the transforms of grid that order bands, rows, stacks and
+		columns by invariants of their clues and label digits in order of
+		first appearance, returning the transform taking grid to it.
+
+		Equivalent puzzles share a canonical form, apart from ones so
+		symmetric that their ties leave more than max_candidates transforms
+		to compare, where every tie past that budget is broken by position.
+		Either way the transform is a true symmetry, so it is always safe to
+		solve canonical in place of grid
+	*/
+	Transform canonicalize(Sudoku::Grid const& grid, Sudoku::Grid& canonical);
+
+	static int32_t constexpr max_candidates = 256;
+}
+#endif // SYMMETRY_H
@@ -0,0 +1,274 @@
+﻿#include "Validate.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VALIDATE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VALIDATE_NEON
+#endif
+
+namespace
+{
+	using validate::lanes;
+
+	int32_t constexpr size = Sudoku::size;
+	int32_t constexpr units = size * 3;
+
+	// Bit d - 1 stands for the digit d, bit 15 for a value out of range
+	uint16_t constexpr all_digits = 0x1FF;
+	uint16_t constexpr out_of_range = 0x8000;
+
+	// The bits of one cell of every grid of a group
+	struct alignas(32) Lanes
+	{
+		uint16_t lane[lanes];
+	};
+
+	/**
+		A Lanes in registers, one AVX2 register, two SSE2 or NEON registers,
+		or plain integers where none of those is available
+	*/
+	struct Vector
+	{
+#if defined(__AVX2__)
+		__m256i v;
+
+		static Vector load(Lanes const& from)
+		{
+			return { _mm256_load_si256(reinterpret_cast<__m256i const*>(from.lane)) };
+		}
+
+		static Vector splat(uint16_t value)
+		{
+			return { _mm256_set1_epi16(static_cast<short>(value)) };
+		}
+
+		void store(Lanes& to) const
+		{
+			_mm256_store_si256(reinterpret_cast<__m256i*>(to.lane), v);
+		}
+
+		Vector operator|(Vector other) const { return { _mm256_or_si256(v, other.v) }; }
+		Vector operator&(Vector other) const { return { _mm256_and_si256(v, other.v) }; }
+
+		// this & ~other
+		Vector andNot(Vector other) const { return { _mm256_andnot_si256(other.v, v) }; }
+#elif defined(VALIDATE_SSE2)
+		__m128i lo;
+		__m128i hi;
+
+		static Vector load(Lanes const& from)
+		{
+			return { _mm_load_si128(reinterpret_cast<__m128i const*>(from.lane)),
+				_mm_load_si128(reinterpret_cast<__m128i const*>(from.lane + 8)) };
+		}
+
+		static Vector splat(uint16_t value)
+		{
+			return { _mm_set1_epi16(static_cast<short>(value)), _mm_set1_epi16(static_cast<short>(value)) };
+		}
+
+		void store(Lanes& to) const
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(to.lane), lo);
+			_mm_store_si128(reinterpret_cast<__m128i*>(to.lane + 8), hi);
+		}
+
+		Vector operator|(Vector other) const { return { _mm_or_si128(lo, other.lo), _mm_or_si128(hi, other.hi) }; }
+		Vector operator&(Vector other) const { return { _mm_and_si128(lo, other.lo), _mm_and_si128(hi, other.hi) }; }
+		Vector andNot(Vector other) const { return { _mm_andnot_si128(other.lo, lo), _mm_andnot_si128(other.hi, hi) }; }
+#elif defined(VALIDATE_NEON)
+		uint16x8_t lo;
+		uint16x8_t hi;
+
+		static Vector load(Lanes const& from)
+		{
+			return { vld1q_u16(from.lane), vld1q_u16(from.lane + 8) };
+		}
+
+		static Vector splat(uint16_t value)
+		{
+			return { vdupq_n_u16(value), vdupq_n_u16(value) };
+		}
+
+		void store(Lanes& to) const
+		{
+			vst1q_u16(to.lane, lo);
+			vst1q_u16(to.lane + 8, hi);
+		}
+
+		Vector operator|(Vector other) const { return { vorrq_u16(lo, other.lo), vorrq_u16(hi, other.hi) }; }
+		Vector operator&(Vector other) const { return { vandq_u16(lo, other.lo), vandq_u16(hi, other.hi) }; }
+		Vector andNot(Vector other) const { return { vbicq_u16(lo, other.lo), vbicq_u16(hi, other.hi) }; }
+#else
+		Lanes v;
+
+		static Vector load(Lanes const& from)
+		{
+			return { from };
+		}
+
+		static Vector splat(uint16_t value)
+		{
+			Vector result;
+			std::fill(result.v.lane, result.v.lane + lanes, value);
+			return result;
+		}
+
+		void store(Lanes& to) const
+		{
+			to = v;
+		}
+
+		template <typename Op>
+		Vector combine(Vector other, Op op) const
+		{
+			Vector result;
+			for (size_t i = 0; i < lanes; ++i)
+			{
+				result.v.lane[i] = static_cast<uint16_t>(op(v.lane[i], other.v.lane[i]));
+			}
+			return result;
+		}
+
+		Vector operator|(Vector other) const { return combine(other, [](uint32_t a, uint32_t b) { return a | b; }); }
+		Vector operator&(Vector other) const { return combine(other, [](uint32_t a, uint32_t b) { return a & b; }); }
+		Vector andNot(Vector other) const { return combine(other, [](uint32_t a, uint32_t b) { return a & ~b; }); }
+#endif
+	};
+
+	// The cells of each unit, rows first then columns then boxes
+	struct Units
+	{
+		uint8_t cells[units][size];
+	};
+
+	constexpr Units buildUnits()
+	{
+		Units result{};
+		for (int32_t i = 0; i < size; ++i)
+		{
+			for (int32_t j = 0; j < size; ++j)
+			{
+				result.cells[i][j] = static_cast<uint8_t>(i * size + j);
+				result.cells[size + i][j] = static_cast<uint8_t>(j * size + i);
+				result.cells[2 * size + i][j] = static_cast<uint8_t>((i / 3) * 27 + (i % 3) * 3 + (j / 3) * 9 + j % 3);
+			}
+		}
+		return result;
+	}
+
+	constexpr Units unit_cells = buildUnits();
+
+	/**
+		The digit bits of count grids, cell by cell, lanes past count left
+		empty so they pass every check
+	*/
+	void gather(Sudoku::Grid const* grids, size_t count, Lanes* bits)
+	{
+		for (int32_t cell = 0; cell < Sudoku::grid_size; ++cell)
+		{
+			for (size_t lane = 0; lane < lanes; ++lane)
+			{
+				int32_t const value = lane < count ? grids[lane][cell] : 0;
+				bits[cell].lane[lane] = value == 0 ? 0
+					: value > 0 && value <= size ? static_cast<uint16_t>(1u << (value - 1))
+					: out_of_range;
+			}
+		}
+	}
+
+	/**
+		For every lane, the bits of digits some unit holds more than once
+		ORed with any value out of range, and the bits of every unit ANDed
+		together, which is all_digits only when every unit holds every digit
+	*/
+	void checkUnits(Lanes const* bits, Lanes& repeated, Lanes& complete)
+	{
+		Vector any_repeated = Vector::splat(0);
+		Vector all_complete = Vector::splat(all_digits);
+
+		for (int32_t u = 0; u < units; ++u)
+		{
+			Vector seen = Vector::splat(0);
+			for (int32_t i = 0; i < size; ++i)
+			{
+				Vector const cell = Vector::load(bits[unit_cells.cells[u][i]]);
+				any_repeated = any_repeated | (seen & cell);
+				seen = seen | cell;
+			}
+
+			any_repeated = any_repeated | (seen & Vector::splat(out_of_range));
+			all_complete = all_complete & seen;
+		}
+
+		any_repeated.store(repeated);
+		all_complete.store(complete);
+	}
+
+	/**
+		For every lane, the bits of clues the solution has another digit in
+	*/
+	void findChanged(Lanes const* clues, Lanes const* bits, Lanes& changed)
+	{
+		Vector any_changed = Vector::splat(0);
+		for (int32_t cell = 0; cell < Sudoku::grid_size; ++cell)
+		{
+			any_changed = any_changed | Vector::load(clues[cell]).andNot(Vector::load(bits[cell]));
+		}
+		any_changed.store(changed);
+	}
+}
+
+namespace validate
+{
+	void checkClues(Sudoku::Grid const* grids, size_t count, bool* consistent)
+	{
+		Lanes bits[Sudoku::grid_size];
+		for (size_t first = 0; first < count; first += lanes)
+		{
+			size_t const group = std::min(lanes, count - first);
+			gather(grids + first, group, bits);
+
+			Lanes repeated;
+			Lanes complete;
+			checkUnits(bits, repeated, complete);
+
+			for (size_t lane = 0; lane < group; ++lane)
+			{
+				consistent[first + lane] = repeated.lane[lane] == 0;
+			}
+		}
+	}
+
+	void checkSolutions(Sudoku::Grid const* puzzles, Sudoku::Grid const* solutions, size_t count,
+		bool* valid)
+	{
+		Lanes clues[Sudoku::grid_size];
+		Lanes bits[Sudoku::grid_size];
+		for (size_t first = 0; first < count; first += lanes)
+		{
+			size_t const group = std::min(lanes, count - first);
+			gather(puzzles + first, group, clues);
+			gather(solutions + first, group, bits);
+
+			Lanes repeated;
+			Lanes complete;
+			Lanes changed;
+			checkUnits(bits, repeated, complete);
+			findChanged(clues, bits, changed);
+
+			for (size_t lane = 0; lane < group; ++lane)
+			{
+				valid[first + lane] = repeated.lane[lane] == 0 && complete.lane[lane] == all_digits &&
+					changed.lane[lane] == 0;
+			}
+		}
+	}
+}
@@ -0,0 +1,34 @@
+﻿#ifndef VALIDATE_H
+#define VALIDATE_H
+#include "Sudoku.h"
+
+#include <cstddef>
+
+/**
+	Checks of many 9x9 grids at once, for rejecting contradicting clues
+	before any search and verifying the solutions that come out of it.
+
+	Grids are checked lanes at a time, each cell of every grid of a group
+	turned to a digit bit in a lane of one array, so a unit is checked for
+	all of them by a few wide ORs and ANDs
+*/
+namespace validate
+{
+	// Grids checked together, 256 bits of 16 bit lanes
+	static size_t constexpr lanes = 16;
+
+	/**
+		For each of count grids set consistent[i] to whether every cell of
+		grids[i] is 0 to 9 and no row, column or box holds a digit twice
+	*/
+	void checkClues(Sudoku::Grid const* grids, size_t count, bool* consistent);
+
+	/**
+		For each of count grids set valid[i] to whether solutions[i] is a
+		filled grid holding every digit once in each row, column and box,
+		which agrees with every clue of puzzles[i]
+	*/
+	void checkSolutions(Sudoku::Grid const* puzzles, Sudoku::Grid const* solutions, size_t count,
+		bool* valid);
+}
+#endif // VALIDATE_H
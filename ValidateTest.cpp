@@ -0,0 +1,197 @@
+﻿/**
+	Check of the grouped clue and solution checks of Validate.cpp against
+	a plain reference checking one grid at a time
+
+	Grids are valid solutions and puzzles taken from them, mutated at
+	random so every way of failing a check turns up, in counts that are
+	not a multiple of validate::lanes so partial groups are covered. The
+	variant checked is the one the build targets, AVX2 with SUDOKU_NATIVE
+	on a CPU having it, SSE2 or NEON otherwise.
+*/
+#include "Validate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int32_t constexpr size = Sudoku::size;
+	int32_t constexpr grid_size = Sudoku::grid_size;
+
+	// Grids checked, not a multiple of validate::lanes so the last group is partial
+	size_t constexpr grid_count = 20000 - 3;
+
+	int32_t unitCell(int32_t unit, int32_t i)
+	{
+		int32_t const kind = unit / size;
+		int32_t const k = unit % size;
+		return kind == 0 ? k * size + i
+			: kind == 1 ? i * size + k
+			: (k / 3) * 27 + (k % 3) * 3 + (i / 3) * 9 + i % 3;
+	}
+
+	/**
+		Whether every cell of grid is 0 to 9 and no unit holds a digit twice
+	*/
+	bool referenceClues(Sudoku::Grid const& grid)
+	{
+		for (int32_t value : grid)
+		{
+			if (value < 0 || value > size)
+			{
+				return false;
+			}
+		}
+		for (int32_t unit = 0; unit < 3 * size; ++unit)
+		{
+			bool seen[size + 1] = {};
+			for (int32_t i = 0; i < size; ++i)
+			{
+				int32_t const value = grid[unitCell(unit, i)];
+				if (value != 0 && seen[value])
+				{
+					return false;
+				}
+				seen[value] = true;
+			}
+		}
+		return true;
+	}
+
+	/**
+		Whether solution is filled, consistent and agrees with every clue
+	*/
+	bool referenceSolution(Sudoku::Grid const& puzzle, Sudoku::Grid const& solution)
+	{
+		for (int32_t cell = 0; cell < grid_size; ++cell)
+		{
+			if (solution[cell] == 0 || (puzzle[cell] != 0 && puzzle[cell] != solution[cell]))
+			{
+				return false;
+			}
+		}
+		return referenceClues(solution);
+	}
+
+	/**
+		A solved grid, a shifted pattern with its digits, rows and columns
+		within bands shuffled
+	*/
+	Sudoku::Grid randomSolution(std::mt19937& random)
+	{
+		int32_t digits[size];
+		int32_t rows[size];
+		int32_t columns[size];
+		for (int32_t i = 0; i < size; ++i)
+		{
+			digits[i] = i + 1;
+			rows[i] = i;
+			columns[i] = i;
+		}
+		std::shuffle(digits, digits + size, random);
+		for (int32_t band = 0; band < size; band += 3)
+		{
+			std::shuffle(rows + band, rows + band + 3, random);
+			std::shuffle(columns + band, columns + band + 3, random);
+		}
+
+		Sudoku::Grid grid;
+		for (int32_t r = 0; r < size; ++r)
+		{
+			for (int32_t c = 0; c < size; ++c)
+			{
+				int32_t const row = rows[r];
+				int32_t const column = columns[c];
+				grid[r * size + c] = digits[(row * 3 + row / 3 + column) % size];
+			}
+		}
+		return grid;
+	}
+
+	/**
+		Change a few cells of grid, to other digits, zero, or a value out of
+		range, or swap two of them, each about as often
+	*/
+	void mutate(Sudoku::Grid& grid, std::mt19937& random)
+	{
+		std::uniform_int_distribution<int32_t> cells(0, grid_size - 1);
+		std::uniform_int_distribution<int32_t> kinds(0, 3);
+		int32_t const changes = std::uniform_int_distribution<int32_t>(1, 3)(random);
+		for (int32_t k = 0; k < changes; ++k)
+		{
+			int32_t const cell = cells(random);
+			switch (kinds(random))
+			{
+			case 0:
+				grid[cell] = std::uniform_int_distribution<int32_t>(1, size)(random);
+				break;
+			case 1:
+				grid[cell] = 0;
+				break;
+			case 2:
+				grid[cell] = std::uniform_int_distribution<int32_t>(0, 1)(random) ? -1 : size + 1;
+				break;
+			default:
+				std::swap(grid[cell], grid[cells(random)]);
+				break;
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 random(20000);
+	std::vector<Sudoku::Grid> puzzles(grid_count);
+	std::vector<Sudoku::Grid> solutions(grid_count);
+
+	for (size_t i = 0; i < grid_count; ++i)
+	{
+		solutions[i] = randomSolution(random);
+		puzzles[i] = solutions[i];
+		for (int32_t& value : puzzles[i])
+		{
+			if (std::uniform_int_distribution<int32_t>(0, 2)(random) != 0)
+			{
+				value = 0;
+			}
+		}
+
+		// Half of each left valid for either check, so both outcomes are common
+		if (i % 2 == 0)
+		{
+			mutate(puzzles[i], random);
+		}
+		if (i % 4 < 2)
+		{
+			mutate(solutions[i], random);
+		}
+	}
+
+	std::unique_ptr<bool[]> flags(new bool[grid_count]);
+	size_t failures = 0;
+	size_t consistent = 0;
+	size_t valid = 0;
+
+	validate::checkClues(puzzles.data(), grid_count, flags.get());
+	for (size_t i = 0; i < grid_count; ++i)
+	{
+		failures += flags[i] != referenceClues(puzzles[i]) ? 1 : 0;
+		consistent += flags[i] ? 1 : 0;
+	}
+
+	validate::checkSolutions(puzzles.data(), solutions.data(), grid_count, flags.get());
+	for (size_t i = 0; i < grid_count; ++i)
+	{
+		failures += flags[i] != referenceSolution(puzzles[i], solutions[i]) ? 1 : 0;
+		valid += flags[i] ? 1 : 0;
+	}
+
+	std::cout << grid_count << " grids, " << consistent << " consistent clues, "
+		<< valid << " valid solutions, " << failures << " disagreeing with the reference\n";
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,565 @@
+﻿#include "Batch.h"
+#include "Enumerate.h"
+#include "Generator.h"
+#include "Server.h"
+#include "SolutionCache.h"
+#include "Sudoku.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	void printGrid(std::ostream& out, Sudoku::Grid const& grid)
+	{
+		out << "-----\n";
+		for (int32_t i = 0; i < 9; ++i)
+		{
+			for (int32_t j = 0; j < 9; ++j)
+			{
+				out << grid[i * 9 + j] << " ";
+			}
+			out << "\n";
+		}
+		out << "-----\n";
+	}
+
+	/**
+		Whether the paths name one file, as when output would truncate the
+		input it is reading. Always false where stat gives no inode
+	*/
+	bool sameFile(char const* first, char const* second)
+	{
+#if defined(_WIN32)
+		(void)first;
+		(void)second;
+		return false;
+#else
+		struct stat a;
+		struct stat b;
+		return stat(first, &a) == 0 && stat(second, &b) == 0 &&
+			a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#endif
+	}
+
+	void printUsage(char const* name)
+	{
+		std::cerr << "usage: " << name << " [--threads N] [--backend B] [--engine E] [--propagate] [--split]\n"
+			<< "       [--node-limit N] [--time-limit MS] [--stats] [--cache N] [--output FILE] [file]\n"
+			<< "       " << name << " --generate N [--seed S] [--threads N]\n"
+			<< "       " << name << " --serve | --socket PATH [solver options]\n"
+			<< "       " << name << " --enumerate [--output FILE] [solver options] file\n"
+			<< "       " << name << " --decode file\n"
+			<< "  with no arguments solve the built in example puzzle\n"
+			<< "  file             solve each 81 character puzzle line of file, - reads stdin\n"
+			<< "  --threads N      worker threads for file solving, defaults to one per core\n"
+			<< "  --backend B      solver, dlx (default) for dancing links, dlx2 for dancing links\n"
+			<< "                   with rows between spacers, bitboard, or routed\n"
+			<< "                   to propagate singles first and pick a search for the rest\n"
+			<< "  --engine E       dancing links search, recursive (default), iterative or\n"
+			<< "                   interleaved, several iterative searches per thread taking turns\n"
+			<< "  --propagate      dancing links picks forced rows without branching\n"
+			<< "  --split          solve one puzzle at a time, splitting each over the threads\n"
+			<< "  --node-limit N   give up on a puzzle after N search nodes\n"
+			<< "  --time-limit MS  give up on a puzzle after MS milliseconds of search\n"
+			<< "  --stats          print dancing links search totals after solving a file\n"
+			<< "  --cache N        remember the solutions of up to N puzzles, answering any\n"
+			<< "                   puzzle equivalent by symmetry to one of them without search\n"
+			<< "  --output FILE    write solutions to FILE rather than stdout, mapping both\n"
+			<< "                   files into memory when file is not stdin\n"
+			<< "  --generate N     write N random minimal puzzles with a unique solution\n"
+			<< "  --seed S         first seed of --generate, each puzzle one further\n"
+			<< "  --serve          answer 81 byte puzzle requests on stdin with 82 byte replies\n"
+			<< "                   on stdout, the solution and a status byte U, M, N, T or X\n"
+			<< "  --socket PATH    serve the same requests to connections to a Unix socket\n"
+			<< "  --enumerate      write every solution of each puzzle of file in binary, each\n"
+			<< "                   as the cells changed from the solution before\n"
+			<< "  --decode         print the solutions of a --enumerate file, one per line and\n"
+			<< "                   an empty line after the solutions of each puzzle\n";
+	}
+
+	void printSearchStats(std::ostream& out, SearchStats<3> const& stats)
+	{
+		using Seconds = std::chrono::duration<double>;
+
+		out << stats.nodes << " nodes, " << stats.covers << " covers, " << stats.uncovers
+			<< " uncovers, " << stats.links << " link updates\n"
+			<< Seconds(stats.load_time).count() << "s loading clues, "
+			<< Seconds(stats.search_time).count() << "s searching\n"
+			<< "branches by depth and rows of the column chosen:\n";
+
+		for (int32_t k = 0; k <= stats.max_depth; ++k)
+		{
+			uint64_t total = 0;
+			for (int32_t n = 0; n <= stats.size; ++n)
+			{
+				total += stats.branching[k][n];
+			}
+			if (total == 0)
+			{
+				continue;
+			}
+
+			out << k << ":";
+			for (int32_t n = 0; n <= stats.size; ++n)
+			{
+				out << " " << stats.branching[k][n];
+			}
+			out << "\n";
+		}
+	}
+
+	int solveExample()
+	{
+		Sudoku sudoku;
+
+		// 19/02/2022 NYTimes hard sudoku
+		Sudoku::Grid const grid = {
+			0,7,0, 4,8,0, 1,3,0,
+			0,0,0, 0,0,0, 0,0,0,
+			0,0,0, 5,6,0, 0,8,0,
+
+			0,6,0, 0,0,8, 0,7,0,
+			0,4,1, 0,0,6, 0,0,0,
+			0,0,8, 0,0,0, 0,1,0,
+
+			0,9,0, 3,0,0, 2,0,8,
+			0,0,5, 0,0,2, 0,0,0,
+			4,0,0, 0,7,0, 5,0,0
+		};
+
+		SolveResult const result = sudoku.loadGridAndSolve(grid,
+			[](Sudoku::Grid const& solution) { printGrid(std::cout, solution); });
+
+		if (result.solutions == 0)
+		{
+			std::cout << (result.invalid ? "invalid grid" : "no solution") << std::endl;
+		}
+
+		return 0;
+	}
+
+	int solveFile(char const* path, char const* output, batch::BatchOptions const& options)
+	{
+		bool const from_stdin = std::strcmp(path, "-") == 0;
+		batch::BatchStats stats;
+
+		// Files on both sides are mapped, anything else is streamed
+		if (from_stdin || !output || !batch::solveMappedFile(path, output, options, stats))
+		{
+			std::ifstream file;
+			if (!from_stdin)
+			{
+				file.open(path);
+				if (!file)
+				{
+					std::cerr << "could not open " << path << "\n";
+					return 1;
+				}
+			}
+
+			std::ofstream out_file;
+			if (output)
+			{
+				out_file.open(output, std::ios::binary);
+				if (!out_file)
+				{
+					std::cerr << "could not open " << output << "\n";
+					return 1;
+				}
+			}
+
+			stats = batch::solveStream(file.is_open() ? file : std::cin,
+				out_file.is_open() ? out_file : std::cout, options);
+		}
+
+		std::cerr << stats.puzzles << " puzzles in " << stats.seconds << "s ("
+			<< (stats.seconds > 0.0 ? stats.puzzles / stats.seconds : 0.0) << " puzzles/s), "
+			<< stats.solved << " solved, " << stats.unsolvable << " unsolvable, "
+			<< stats.malformed << " malformed";
+		if (stats.timeouts > 0)
+		{
+			std::cerr << ", " << stats.timeouts << " timed out";
+		}
+		if (options.cache)
+		{
+			std::cerr << ", " << stats.cache_hits << " cache hits";
+		}
+		if (stats.unverified > 0)
+		{
+			std::cerr << ", " << stats.unverified << " failed verification";
+		}
+		if (options.backend == batch::Backend::Routed)
+		{
+			std::cerr << ", " << stats.singles << " by singles, " << stats.routed_bitboard
+				<< " to bitboard, " << stats.routed_dancing_links << " to dancing links";
+		}
+		std::cerr << "\n";
+
+		if (options.stats)
+		{
+			printSearchStats(std::cerr, stats.search);
+		}
+
+		return 0;
+	}
+
+	int enumerateFile(char const* path, char const* output, batch::BatchOptions const& options)
+	{
+		std::ifstream file;
+		if (std::strcmp(path, "-") != 0)
+		{
+			file.open(path);
+			if (!file)
+			{
+				std::cerr << "could not open " << path << "\n";
+				return 1;
+			}
+		}
+
+		std::ofstream out_file;
+		if (output)
+		{
+			out_file.open(output, std::ios::binary);
+			if (!out_file)
+			{
+				std::cerr << "could not open " << output << "\n";
+				return 1;
+			}
+		}
+
+		enumerate::EnumerateStats const stats = enumerate::enumerateStream(file.is_open() ? file : std::cin,
+			out_file.is_open() ? out_file : std::cout, options);
+
+		std::cerr << stats.puzzles << " puzzles in " << stats.seconds << "s, " << stats.solutions
+			<< " solutions (" << (stats.seconds > 0.0 ? stats.solutions / stats.seconds : 0.0)
+			<< " solutions/s) in " << stats.bytes << " bytes, " << stats.malformed << " malformed";
+		if (stats.timeouts > 0)
+		{
+			std::cerr << ", " << stats.timeouts << " timed out";
+		}
+		std::cerr << "\n";
+		return 0;
+	}
+
+	int decodeFile(char const* path)
+	{
+		std::ifstream file;
+		if (std::strcmp(path, "-") != 0)
+		{
+			file.open(path, std::ios::binary);
+			if (!file)
+			{
+				std::cerr << "could not open " << path << "\n";
+				return 1;
+			}
+		}
+
+		enumerate::SolutionReader reader(file.is_open() ? file : std::cin);
+		Sudoku::Grid solution;
+		char record[batch::line_length + 1];
+		record[batch::line_length] = '\n';
+
+		for (;;)
+		{
+			switch (reader.next(solution))
+			{
+			case enumerate::SolutionReader::Entry::Solution:
+				batch::formatGrid(solution, record);
+				std::cout.write(record, sizeof(record));
+				break;
+			case enumerate::SolutionReader::Entry::EndOfPuzzle:
+				std::cout << "\n";
+				break;
+			case enumerate::SolutionReader::Entry::EndOfStream:
+				return 0;
+			default:
+				std::cerr << path << " is not a complete --enumerate file\n";
+				return 1;
+			}
+		}
+	}
+
+	/**
+		Generate count puzzles on threads generators, puzzle i from seed + i
+		so the output is the same whatever the number of threads
+	*/
+	int generatePuzzles(uint64_t count, uint64_t seed, int32_t threads)
+	{
+		auto const start = std::chrono::steady_clock::now();
+
+		size_t constexpr record_size = batch::line_length + 1;
+		std::vector<char> records(count * record_size);
+		std::vector<Generator> generators(static_cast<size_t>(std::max(threads, 1)));
+		std::atomic<uint64_t> cursor(0);
+		std::atomic<uint64_t> clues(0);
+
+		auto const work = [&](size_t worker)
+		{
+			for (uint64_t i = cursor.fetch_add(1); i < count; i = cursor.fetch_add(1))
+			{
+				Sudoku::Grid const puzzle = generators[worker].generate(seed + i);
+				char* const record = &records[i * record_size];
+				batch::formatGrid(puzzle, record);
+				std::replace(record, record + batch::line_length, '0', '.');
+				record[batch::line_length] = '\n';
+				clues.fetch_add(static_cast<uint64_t>(std::count_if(puzzle.begin(), puzzle.end(),
+					[](int32_t value) { return value != 0; })));
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t worker = 1; worker < generators.size(); ++worker)
+		{
+			workers.emplace_back(work, worker);
+		}
+		work(0);
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		std::cout.write(records.data(), static_cast<std::streamsize>(records.size()));
+		std::cout.flush();
+
+		double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cerr << count << " puzzles generated in " << seconds << "s ("
+			<< (seconds > 0.0 ? count / seconds : 0.0) << " puzzles/s), "
+			<< (count > 0 ? static_cast<double>(clues.load()) / count : 0.0) << " clues on average\n";
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::ios::sync_with_stdio(false);
+
+	char const* path = nullptr;
+	char const* output = nullptr;
+	uint64_t generate = 0;
+	uint64_t seed = 1;
+	bool serve = false;
+	bool enumerate = false;
+	bool decode = false;
+	std::unique_ptr<SolutionCache> cache;
+	char const* socket_path = nullptr;
+	batch::BatchOptions options;
+	options.threads = static_cast<int32_t>(std::thread::hardware_concurrency());
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			options.threads = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+		{
+			char const* const backend = argv[++i];
+			if (std::strcmp(backend, "dlx") == 0)
+			{
+				options.backend = batch::Backend::DancingLinks;
+			}
+			else if (std::strcmp(backend, "dlx2") == 0)
+			{
+				options.backend = batch::Backend::SpacedLinks;
+			}
+			else if (std::strcmp(backend, "bitboard") == 0)
+			{
+				options.backend = batch::Backend::Bitboard;
+			}
+			else if (std::strcmp(backend, "routed") == 0)
+			{
+				options.backend = batch::Backend::Routed;
+			}
+			else
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--propagate") == 0)
+		{
+			options.propagation = true;
+		}
+		else if (std::strcmp(argv[i], "--node-limit") == 0 && i + 1 < argc)
+		{
+			// strtoull takes "-1" as the largest limit rather than refusing it
+			char const* const nodes = argv[++i];
+			if (nodes[0] == '-')
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.limits.nodes = std::strtoull(nodes, nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+		{
+			options.limits.time = std::chrono::milliseconds(std::max(std::atoi(argv[++i]), 0));
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0)
+		{
+			options.stats = true;
+		}
+		else if (std::strcmp(argv[i], "--generate") == 0 && i + 1 < argc)
+		{
+			generate = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+		{
+			uint64_t const capacity = std::strtoull(argv[++i], nullptr, 10);
+			cache.reset(capacity > 0 ? new SolutionCache(static_cast<size_t>(capacity)) : nullptr);
+			options.cache = cache.get();
+		}
+		else if (std::strcmp(argv[i], "--serve") == 0)
+		{
+			serve = true;
+		}
+		else if (std::strcmp(argv[i], "--enumerate") == 0)
+		{
+			enumerate = true;
+		}
+		else if (std::strcmp(argv[i], "--decode") == 0)
+		{
+			decode = true;
+		}
+		else if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+		{
+			socket_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			output = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--split") == 0)
+		{
+			options.split = true;
+		}
+		else if (std::strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+		{
+			char const* const engine = argv[++i];
+			if (std::strcmp(engine, "recursive") == 0)
+			{
+				options.engine = SearchEngine::Recursive;
+			}
+			else if (std::strcmp(engine, "iterative") == 0)
+			{
+				options.engine = SearchEngine::Iterative;
+			}
+			else if (std::strcmp(engine, "interleaved") == 0)
+			{
+				options.engine = SearchEngine::Interleaved;
+			}
+			else
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (!path && (argv[i][0] != '-' || argv[i][1] == '\0'))
+		{
+			path = argv[i];
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// The server answers with a status needing a count of solutions, which
+	// neither routing nor the cache gives
+	if ((socket_path || serve) && (options.backend == batch::Backend::Routed || options.cache))
+	{
+		std::cerr << "--serve and --socket take neither --backend routed nor --cache\n";
+		return 1;
+	}
+
+	// Only the recursive and iterative searches are instrumented
+	if (options.stats && options.engine == SearchEngine::Interleaved)
+	{
+		std::cerr << "--stats does not take --engine interleaved\n";
+		return 1;
+	}
+
+	if (socket_path)
+	{
+		server::listen(socket_path, options);
+		std::cerr << "could not listen on " << socket_path << "\n";
+		return 1;
+	}
+
+	if (serve)
+	{
+		return server::serve(0, 1, options) ? 0 : 1;
+	}
+
+	if (generate > 0)
+	{
+		return generatePuzzles(generate, seed, options.threads);
+	}
+
+	if ((enumerate || decode) && !path)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	if (path && output && sameFile(path, output))
+	{
+		std::cerr << output << " is the input file, give another --output\n";
+		return 1;
+	}
+
+	if (decode)
+	{
+		return decodeFile(path);
+	}
+
+	if (enumerate)
+	{
+		if (options.backend != batch::Backend::DancingLinks)
+		{
+			std::cerr << "--enumerate only takes --backend dlx\n";
+			return 1;
+		}
+
+		// The cache keeps only a first solution, and enumeration searches
+		// each puzzle whole on one solver
+		if (options.cache || options.split)
+		{
+			std::cerr << "--enumerate takes neither --cache nor --split\n";
+			return 1;
+		}
+		return enumerateFile(path, output, options);
+	}
+
+	if (!path)
+	{
+		return solveExample();
+	}
+
+	return solveFile(path, output, options);
+}